@@ -8,7 +8,7 @@
 
 // Target Platform: EK-TM4C123GXL Evaluation Board
 // Target uC:       TM4C123GH6PM
-// System Clock:    40 MHz
+// System Clock:    80 MHz
 
 //-----------------------------------------------------------------------------
 // Device includes, defines, and assembler directives
@@ -18,13 +18,35 @@
 #include <stdbool.h>
 #include "tm4c123gh6pm.h"
 #include "gpio.h"
-#include "wait.h"
 #include "clock.h"
 #include "uart0.h"
 #include "conversion.h"
 #include "motorControl.h"
 #include "nvic.h"
 #include "i2c1.h"
+#include "wheelSpeed.h"
+#include "odometry.h"
+#include "slipMonitor.h"
+#include "lqrControl.h"
+#include "lqrGains.h"
+#include "timing.h"
+#include "scheduler.h"
+#include "timebase.h"
+#include "priorities.h"
+#include "latencyTest.h"
+#include "profiler.h"
+#include "power.h"
+#include "watchdog.h"
+#include "crash.h"
+#include "stackMonitor.h"
+#include "events.h"
+#include "lineEditor.h"
+#include "telemetry.h"
+#include "commands.h"
+#include "script.h"
+#include "scope.h"
+#include "eeprom.h"
+#include "config.h"
 #include <math.h>
 //#include "irDecoder.h"
 
@@ -51,10 +73,24 @@
 #define PB_1            PORTF, 4
 #define PB_2            PORTF, 0
 
+#define BUTTON_DEBOUNCE_US 50000
+#define BAUD_CONFIRM_US    2000000   // host has this long to send "ok" at a new baud rate
+
+#define DRIVE_US_PER_M     2600000   // timed straight moves, 850 PWM
+#define DRIVE_MAX_M        10
+#define ROTATE_MAX_DEG     180
+#define ROTATE_TIMEOUT_US  5000000   // a turn that hasn't reached its angle by then is stopped, a wheel is stuck
+
+#define BALANCE_PERIOD_MS  25        // balance task, the LQR gains are discretized for it
+
+#if BALANCE_PERIOD_MS != LQR_PERIOD_MS
+#error "lqrGains.h was generated for another period, rerun tools/lqr_gains.py --period"
+#endif
+
 #define MPU6050         0x68  // 110 1000 = 0x68 = ADDR is logic low
 
 #define MAX_SPEED 1023
-#define MIN_SPEED 850
+#define MIN_SPEED 850    // default, config.minSpeed is used
 
 #define PI 3.1415
 
@@ -112,6 +148,19 @@ typedef enum
     BUTTON_HELD
 } ButtonState;
 
+typedef enum
+{
+    CONTROLLER_PID,
+    CONTROLLER_LQR
+} BalanceController;
+
+// Gain or calibration value "config" shows and sets by name
+typedef struct _CONFIG_FIELD
+{
+    const char* name;
+    float* value;
+} CONFIG_FIELD;
+
 uint32_t lastTime = 0; // Last captured time
 uint32_t pulseWidth = 0;
 
@@ -134,15 +183,26 @@ bool goBalance = true;      // if true robot will balance
 
 bool amRotate = false;
 
+DEADLINE driveDeadline;     // end of a timed move
+bool timedDrive = false;    // CLI forward/reverse or IR 1 m move in progress
+bool rotating = false;      // turn in progress, the motion task stops it
+DEADLINE rotateDeadline;
+
+DEADLINE buttonQuiet;       // push button edges before this are bounce
+volatile bool uartEventQueued = false;  // one EVENT_UART_RX at a time is enough
+
+uint32_t baudFallback = 0;  // rate to go back to if a baud change isn't confirmed, 0 if none is pending
+DEADLINE baudConfirmBy;
+
 uint16_t leftWheelSpeed;
 uint16_t rightWheelSpeed;
 uint16_t currentDirection;
 
-int32_t leftWheelOpticalInterrupt = 0;
-int32_t rightWheelOpticalInterrupt = 0;
+WHEEL_SPEED leftWheel;
+WHEEL_SPEED rightWheel;
 
-int32_t leftWheelDistanceTraveled = 0;
-int32_t rightWheelDistanceTraveled = 0;
+float leftWheelRate = 0.0;  // tabs/s // 1 tab = 1 cm
+float rightWheelRate = 0.0; // tabs/s
 
 int16_t ax, ay, az, gx, gy, gz;
 float fax, fay, faz, fgx, fgy, fgz;
@@ -161,6 +221,47 @@ float lastAx = 0.0;
 float lastAy = 0.0;
 float lastAz = 0.0;
 
+CONFIG config;              // gains and calibration in use, kept over resets with "save"
+
+// Used when the EEPROM has no good copy and by "factory"
+const CONFIG defaultConfig =
+{
+    { 2, 0, 0 },            // balance kp ki kd, ki should be 1/100th to maybe 1/20th of kp
+    { 2.2, 0, 0 },          // straight kp ki kd, 2.5 is okay
+    MIN_SPEED,
+    { FORWARD_FAST, FORWARD_NORMAL, FORWARD_SLOW, BACK_FAST, BACK_NORMAL, BACK_SLOW,
+      ROTATE_LEFT_B, ROTATE_LEFT_F, ROTATE_RIGHT_B, ROTATE_RIGHT_F,
+      ROTATE_CW_90, ROTATE_CW_180, ROTATE_CCW_90, ROTATE_CCW_180,
+      SPINNING_BOI_1, SPINNING_BOI_2, BALANCE, FORWARD_1M, BACK_1M },
+    { 0, 0, 0 },            // gyro bias
+    { 0, 0, 0 }             // accel trim
+};
+
+// Action of each config.irCodes entry, the stock remote sends the action's value
+const char* irKeyNames[CONFIG_IR_KEYS] =
+{
+    "fwd_fast", "fwd_normal", "fwd_slow", "back_fast", "back_normal", "back_slow",
+    "left_b", "left_f", "right_b", "right_f",
+    "cw_90", "cw_180", "ccw_90", "ccw_180",
+    "spin_1", "spin_2", "balance", "fwd_1m", "back_1m"
+};
+
+const CONFIG_FIELD configFields[] =
+{
+    { "bkp", &config.balanceGains[0] }, { "bki", &config.balanceGains[1] }, { "bkd", &config.balanceGains[2] },
+    { "skp", &config.straightGains[0] }, { "ski", &config.straightGains[1] }, { "skd", &config.straightGains[2] },
+    { "gbx", &config.gyroBias[0] }, { "gby", &config.gyroBias[1] }, { "gbz", &config.gyroBias[2] },
+    { "atx", &config.accelTrim[0] }, { "aty", &config.accelTrim[1] }, { "atz", &config.accelTrim[2] }
+};
+
+const ButtonAction irKeyActions[CONFIG_IR_KEYS] =
+{
+    FORWARD_FAST, FORWARD_NORMAL, FORWARD_SLOW, BACK_FAST, BACK_NORMAL, BACK_SLOW,
+    ROTATE_LEFT_B, ROTATE_LEFT_F, ROTATE_RIGHT_B, ROTATE_RIGHT_F,
+    ROTATE_CW_90, ROTATE_CW_180, ROTATE_CCW_90, ROTATE_CCW_180,
+    SPINNING_BOI_1, SPINNING_BOI_2, BALANCE, FORWARD_1M, BACK_1M
+};
+
 //-----------------------------------------------------------------------------
 // Subroutines
 //-----------------------------------------------------------------------------
@@ -168,6 +269,8 @@ float lastAz = 0.0;
 void processDecodedData(uint32_t data);
 void handleButtonAction(void);
 void rotate(uint8_t degrees, bool direction);
+void startRotate(uint8_t degrees, bool direction);
+bool rotateReached(void);
 void readMPU6050();
 
 //-----------------------------------------------------------------------------
@@ -176,10 +279,10 @@ void readMPU6050();
 
 void initHw(void)
 {
-    // Initialize system clock to 40 MHz
-    initSystemClockTo40Mhz();
-    SYSCTL_RCGCTIMER_R  |= SYSCTL_RCGCTIMER_R0  | SYSCTL_RCGCTIMER_R1  | SYSCTL_RCGCTIMER_R2  | SYSCTL_RCGCTIMER_R3;
-    SYSCTL_RCGCWTIMER_R |= SYSCTL_RCGCWTIMER_R0 | SYSCTL_RCGCWTIMER_R1 | SYSCTL_RCGCWTIMER_R2 | SYSCTL_RCGCWTIMER_R3 | SYSCTL_RCGCWTIMER_R4 | SYSCTL_RCGCWTIMER_R5;
+    // Initialize system clock (clock.h)
+    initSystemClock();
+    // Only the timers in use: wheels (WT1, WT5), timebase (WT2), IR (WT3)
+    SYSCTL_RCGCWTIMER_R |= SYSCTL_RCGCWTIMER_R1 | SYSCTL_RCGCWTIMER_R2 | SYSCTL_RCGCWTIMER_R3 | SYSCTL_RCGCWTIMER_R5;
     _delay_cycles(3);
 
     enablePort(PORTA);
@@ -231,7 +334,10 @@ void enableTimerMode()
     WTIMER3_CTL_R |= TIMER_CTL_TAEN;                 // turn-on counter
     NVIC_EN3_R |= 1 << (INT_WTIMER3A-16-96);         // turn-on interrupt 116 (WTIMER3A)
 
+    initOdometry();
+
     // Left Wheel // OPB876N55 Optical Interrupter // PC6 // WT1CCP0
+    initWheelSpeed(&leftWheel);
     WTIMER1_CTL_R &= ~TIMER_CTL_TAEN;                // turn-off counter before reconfiguring
     WTIMER1_CFG_R = 4;                               // configure as 32-bit counter (A only)
     WTIMER1_TAMR_R = TIMER_TAMR_TACMR | TIMER_TAMR_TAMR_CAP | TIMER_TAMR_TACDIR; // configure for edge time mode, count up
@@ -242,6 +348,7 @@ void enableTimerMode()
     NVIC_EN3_R |= 1 << (INT_WTIMER1A-16-96);         // turn-on interrupt 112 (WTIMER1A)
 
     // Right Wheel // OPB876N55 Optical Interrupter // PD6 // WT5CCP0
+    initWheelSpeed(&rightWheel);
     WTIMER5_CTL_R &= ~TIMER_CTL_TAEN;                // turn-off counter before reconfiguring
     WTIMER5_CFG_R = 4;                               // configure as 32-bit counter (A only)
     WTIMER5_TAMR_R = TIMER_TAMR_TACMR | TIMER_TAMR_TAMR_CAP | TIMER_TAMR_TACDIR; // configure for edge time mode, count up
@@ -251,40 +358,10 @@ void enableTimerMode()
     WTIMER5_CTL_R |= TIMER_CTL_TAEN;                 // turn-on counter
     NVIC_EN3_R |= 1 << (INT_WTIMER5A-16-96);         // turn-on interrupt 120 (WTIMER5A)
 
-    ///*
-    // Using WT2CCP0 for Timing stuff
-    WTIMER2_CTL_R &= ~TIMER_CTL_TAEN;                // turn-off counter before reconfiguring
-    WTIMER2_CFG_R = 4;                               // configure as 32-bit counter (A only)
-    WTIMER2_TAMR_R = TIMER_TAMR_TACMR | TIMER_TAMR_TAMR_CAP | TIMER_TAMR_TACDIR; // configure for edge time mode, count up
-    WTIMER2_CTL_R = TIMER_CTL_TAEVENT_POS;           // measure time from negative edge to negative edge
-    WTIMER2_TAV_R = 0;                               // zero counter for first period
-    WTIMER2_CTL_R |= TIMER_CTL_TAEN;                 // turn-on counter
-    //*/
-
-
-    // Time in Seconds = (load / 40,000,000)
-    // Hz = (40,000,000 / load)
-
-    // Configure Timer 1 for PID controller (Balance)
-    TIMER1_CTL_R &= ~TIMER_CTL_TAEN;                 // turn-off timer before reconfiguring
-    TIMER1_CFG_R = TIMER_CFG_32_BIT_TIMER;           // configure as 32-bit timer (A+B)
-    TIMER1_TAMR_R = TIMER_TAMR_TAMR_PERIOD;          // configure for periodic mode (count down)
-    TIMER1_TAILR_R = 1000000;                        // set load value to 40,000 for 1000 Hz interrupt rate // original was 4,000,000 = 10 Hz
-                                                     // I think 5,000,000 would be good, 8 Hz
-                                                     // 1,000,000 = 40 Hz = 25ms
-
-    TIMER1_IMR_R = TIMER_IMR_TATOIM;                 // turn-on interrupts
-    NVIC_EN0_R = 1 << (INT_TIMER1A-16);              // turn-on interrupt 37 (TIMER1A)
-    TIMER1_CTL_R |= TIMER_CTL_TAEN;                  // turn-on timer
-
-    // Configure Timer 2 for PID controller (Driving Straight)
-    TIMER2_CTL_R &= ~TIMER_CTL_TAEN;                 // turn-off timer before reconfiguring
-    TIMER2_CFG_R = TIMER_CFG_32_BIT_TIMER;           // configure as 32-bit timer (A+B)
-    TIMER2_TAMR_R = TIMER_TAMR_TAMR_PERIOD;          // configure for periodic mode (count down)
-    TIMER2_TAILR_R = 400000;                          // set load value to 40000 for 1000 Hz interrupt rate / once per ms
-    TIMER2_IMR_R = TIMER_IMR_TATOIM;                 // turn-on interrupts
-    NVIC_EN0_R = 1 << (INT_TIMER2A-16);              // turn-on interrupt 39 (TIMER2A)
-    TIMER2_CTL_R |= TIMER_CTL_TAEN;                  // turn-on timer
+    // WTIMER2 is the 64-bit microsecond timebase
+    initTimebase();
+
+
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -295,7 +372,7 @@ volatile uint32_t currentTime = 0;
 void IRdecoder(void) //fine tweak still
 {
     // Calculate the pulse width in microseconds
-    pulseWidth = WTIMER3_TAV_R / 40;
+    pulseWidth = WTIMER3_TAV_R / SYSTEM_CLOCK_MHZ;
     //printfUart0("Pulse Width: %u\n", pulseWidth);
     WTIMER3_TAV_R = 0;
 
@@ -305,8 +382,9 @@ void IRdecoder(void) //fine tweak still
         if (pulseWidth >= 95000 && pulseWidth <= 150000)
         {
             noSignalCounter = 0;
+            if (currentButtonState != BUTTON_HELD)
+                postEvent(EVENT_IR_HELD, lastDecodedData);
             currentButtonState = BUTTON_HELD;
-            processDecodedData(lastDecodedData);
             WTIMER3_ICR_R = TIMER_ICR_CAECINT;
             return;
         } else if (pulseWidth >= 2000 && pulseWidth <= 3000) {
@@ -357,14 +435,11 @@ void IRdecoder(void) //fine tweak still
 
             if(bitCount == 31)
             {
-                printfUart0("\nDecoded Data: %u\n", data);
+                traceEvent(TRACE_IR, data);
                 lastDecodedData = data;
-                processDecodedData(data);
                 currentState = NEC_IDLE;
                 currentButtonState = BUTTON_PRESSED;
-
-                actionHeldExecuted = false;
-                actionReleasedExecuted = false;
+                postEvent(EVENT_IR_CODE, data);
             }
         break;
     }
@@ -373,15 +448,225 @@ void IRdecoder(void) //fine tweak still
 
 void wideTimer3Isr()
 {
+    PROFILE_MARK mark = profileEnter();
     togglePinValue(GREEN_LED);
     IRdecoder();
+    wakeFromPark(WAKE_IR);
+    profileExit(PROFILE_IR, mark);
+}
+
+// No repeat code for 200 ms means the button was let go // scheduler task, 50 Hz
+void checkIrRelease()
+{
+    if((WTIMER3_TAV_R / SYSTEM_CLOCK_MHZ) > 200000)
+    {
+        if (currentButtonState != BUTTON_RELEASED)
+            postEvent(EVENT_IR_RELEASE, lastDecodedData);
+        currentButtonState = BUTTON_RELEASED;
+        //currentButtonAction = NONE; // this breaks the code
+
+        //goStraight = false;
+    }
+}
+
+// Main loop check-in, also while the CLI waits for a character
+void checkInMain()
+{
+    watchdogCheckIn(WATCHDOG_MAIN);
+}
+
+// Ends the CLI forward/reverse and IR 1 m moves and script rotations,
+// then moves the script on // scheduler task, 100 Hz
+void checkMotionDone()
+{
+    if (timedDrive && deadlinePassed(driveDeadline))
+    {
+        timedDrive = false;
+        postEvent(EVENT_MOTION_DONE, 0);
+    }
+    if (rotating && (rotateReached() || deadlinePassed(rotateDeadline)))
+    {
+        // Here rather than through an event, every tick late is overshoot
+        rotating = false;
+        turnOffAll();
+        amRotate = false;
+    }
+    stepScript();
+}
+
+// Stops whatever is moving
+void stopMotion()
+{
+    timedDrive = false;
+    rotating = false;
+    goStraight = false;
+    amRotate = false;
+    currentButtonAction = NONE;
+    turnOffAll();
+}
+
+// Push buttons, falling edge // PF4 and PF0
+void buttonIsr()
+{
+    uint8_t button = (GPIO_PORTF_MIS_R & (1 << 4)) ? 1 : 2;  // PB_1 is PF4
+
+    clearPinInterrupt(PB_1);
+    clearPinInterrupt(PB_2);
+    if (deadlinePassed(buttonQuiet))
+    {
+        postEvent(EVENT_BUTTON, button);
+        buttonQuiet = deadlineIn(BUTTON_DEBOUNCE_US);
+    }
+    wakeFromPark(WAKE_BUTTON);
+}
+
+// Rate, divisor error and sampling of a baud setting
+void printBaud(UART0_BAUD* baud)
+{
+    uint16_t error = (baud->error < 0) ? -baud->error : baud->error;
+    printfUart0("%u baud, actual %u, error %c%u.%02u%%, %s sampling\n", baud->requested, baud->actual,
+                (baud->error < 0) ? '-' : '+', error / 100, error % 100, baud->highSpeed ? "8x" : "16x");
+}
+
+// "baud n": the reply goes out at the old rate, then the UART switches and
+// the host has BAUD_CONFIRM_US to switch too and send "ok" at the new one
+void startBaudChange(uint32_t baudRate)
+{
+    UART0_BAUD baud;
+    uint32_t current = getUart0Baud().requested;
+
+    if (!getUart0BaudDivisor(baudRate, SYSTEM_CLOCK_HZ, &baud))
+    {
+        printfUart0("refused, closest is ");
+        printBaud(&baud);
+        return;
+    }
+    printfUart0("switching to ");
+    printBaud(&baud);
+    printfUart0("send ok at the new rate within %u ms\n", BAUD_CONFIRM_US / 1000);
+    if (setUart0BaudRate(baudRate, SYSTEM_CLOCK_HZ))
+    {
+        if (baudFallback == 0)
+            baudFallback = current;
+        baudConfirmBy = deadlineIn(BAUD_CONFIRM_US);
+    }
+}
+
+// Main loop, goes back to the old rate if the host never confirmed
+void checkBaudChange()
+{
+    if ((baudFallback != 0) && deadlinePassed(baudConfirmBy))
+    {
+        setUart0BaudRate(baudFallback, SYSTEM_CLOCK_HZ);
+        baudFallback = 0;
+        printfUart0("\nbaud change not confirmed, back to %u\n", getUart0Baud().requested);
+    }
+}
+
+// UART0 low-water hook, armed by a scope dump waiting for room
+void uartTxLow()
+{
+    postEvent(EVENT_SCOPE_DUMP, 0);
+}
+
+// UART0 receive hook, the characters wait in the receive ring for the line editor
+void uartRxReady()
+{
+    if (!uartEventQueued)
+        uartEventQueued = postEvent(EVENT_UART_RX, 0);
+    wakeFromPark(WAKE_UART);
+}
+
+const char* scriptStateNames[] = { "idle", "loading", "running", "done", "stopped", "aborted on tilt", "aborted, did not settle" };
+
+void printScriptEnd(ScriptState state)
+{
+    SCRIPT_STATUS status = getScriptStatus();
+
+    if (state == SCRIPT_DONE)
+        printfUart0("Script done\n");
+    else
+        printfUart0("Script %s at step %u, tilt %.1f deg\n", scriptStateNames[state], status.step, status.lastTilt);
+}
+
+// IR, buttons, timed moves and scripts // called from the main loop when an event arrives
+void dispatchEvent(EVENT* event)
+{
+    switch (event->type)
+    {
+        case EVENT_IR_CODE:
+            printfUart0("\nDecoded Data: %u\n", event->data);
+            processDecodedData(event->data);
+            actionHeldExecuted = false;
+            actionReleasedExecuted = false;
+            handleButtonAction();
+        break;
+        case EVENT_IR_HELD:
+            processDecodedData(event->data);
+            handleButtonAction();
+        break;
+        case EVENT_IR_RELEASE:
+            handleButtonAction();
+        break;
+
+        case EVENT_MOTION_DONE:
+            if (currentButtonAction == FORWARD_1M || currentButtonAction == BACK_1M)
+            {
+                handleButtonAction();
+            }
+            else
+            {
+                goStraight = false;
+                amRotate = false;
+                turnOffAll();
+            }
+        break;
+
+        case EVENT_BUTTON:
+            if (event->data == 1)
+            {
+                // Stop whatever is moving
+                stopScript();
+                stopMotion();
+                printfUart0("Stopped\n");
+            }
+            else
+            {
+                goBalance ^= 1;
+                printfUart0("Balance %s\n", goBalance ? "on" : "off");
+            }
+        break;
+
+        case EVENT_SCRIPT_END:
+            printScriptEnd(event->data);
+        break;
+
+        case EVENT_SCOPE_DUMP:
+            // What fits in the UART ring, uartTxLow() posts the rest once it drains, the CLI keeps working
+            sendScopeDump();
+        break;
+
+        default:
+        break;
+    }
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+// Code of another remote, learned with "config ir", to what it does
+ButtonAction getIrAction(uint32_t code)
+{
+    uint8_t i;
+
+    for (i = 0; i < CONFIG_IR_KEYS; i++)
+        if (config.irCodes[i] == code)
+            return irKeyActions[i];
+    return NONE;
+}
+
 void processDecodedData(uint32_t data)
 {
-    switch(data)
+    switch(getIrAction(data))
     {
         case FORWARD_FAST:
             currentButtonAction = FORWARD_FAST;
@@ -491,17 +776,14 @@ void processDecodedData(uint32_t data)
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-// This is what is called from main
+// Called from dispatchEvent for IR codes, holds and releases
 void handleButtonAction(void)
 {
     switch(currentButtonAction)
     {
         case NONE:
             // We aint doin nothin brub
-            //actionHeldExecuted = false;
-            //actionReleasedExecuted = false;
-            goStraight = false;
-
+            // Unknown key, a CLI or script move in progress keeps its straightPID
         break;
 
         case FORWARD_FAST:
@@ -510,8 +792,6 @@ void handleButtonAction(void)
                 amRotate = true;
                 setDirection(currentDirection, leftWheelSpeed, rightWheelSpeed); // Both wheels go forwards
                 goStraight = true;
-                leftWheelOpticalInterrupt = 0;
-                rightWheelOpticalInterrupt = 0;
                 actionHeldExecuted = true;
                 actionReleasedExecuted = false;
             }
@@ -519,8 +799,7 @@ void handleButtonAction(void)
             {
                 goStraight = false;
                 amRotate = false;
-                slowDown(1, 1023, 1023);
-                turnOffAll();
+                slowDown(1, 1023, 1023); // stops the motors when done
                 actionReleasedExecuted = true;
                 actionHeldExecuted = false;
                 //currentButtonState = BUTTON_RELEASED;
@@ -531,12 +810,8 @@ void handleButtonAction(void)
             if (currentButtonState == BUTTON_HELD && !actionHeldExecuted)
             {
                 amRotate = true;
-                setDirection(1, 1023, 1023); // Both wheels go forwards
-                waitMicrosecond(100000);
-                setDirection(currentDirection, leftWheelSpeed, rightWheelSpeed); // Both wheels go forwards
+                kickDirection(currentDirection, leftWheelSpeed, rightWheelSpeed); // Both wheels go forwards
                 goStraight = true;
-                leftWheelOpticalInterrupt = 0;
-                rightWheelOpticalInterrupt = 0;
                 actionHeldExecuted = true;
                 actionReleasedExecuted = false;
             }
@@ -556,12 +831,8 @@ void handleButtonAction(void)
             if (currentButtonState == BUTTON_HELD && !actionHeldExecuted)
             {
                 amRotate = true;
-                setDirection(1, 1023, 1023); // Both wheels go forwards
-                waitMicrosecond(100000);
-                setDirection(currentDirection, leftWheelSpeed, rightWheelSpeed); // Both wheels go forwards
+                kickDirection(currentDirection, leftWheelSpeed, rightWheelSpeed); // Both wheels go forwards
                 goStraight = true;
-                leftWheelOpticalInterrupt = 0;
-                rightWheelOpticalInterrupt = 0;
                 actionHeldExecuted = true;
                 actionReleasedExecuted = false;
             }
@@ -584,8 +855,6 @@ void handleButtonAction(void)
                 amRotate = true;
                 setDirection(currentDirection, leftWheelSpeed, rightWheelSpeed); // Both wheels go backwards
                 goStraight = true;
-                leftWheelOpticalInterrupt = 0;
-                rightWheelOpticalInterrupt = 0;
                 actionHeldExecuted = true;
                 actionReleasedExecuted = false;
             }
@@ -593,9 +862,7 @@ void handleButtonAction(void)
             {
                 goStraight = false;
                 amRotate = false;
-                slowDown(0, 1023, 1023);
-
-                turnOffAll();
+                slowDown(0, 1023, 1023); // stops the motors when done
                 actionReleasedExecuted = true;
                 actionHeldExecuted = false;
                 //currentButtonState = BUTTON_RELEASED;
@@ -606,12 +873,8 @@ void handleButtonAction(void)
             if (currentButtonState == BUTTON_HELD && !actionHeldExecuted)
             {
                 amRotate = true;
-                setDirection(0, 1023, 1023); // Both wheels go backwards
-                waitMicrosecond(100000);
-                setDirection(currentDirection, leftWheelSpeed, rightWheelSpeed); // Both wheels go backwards
+                kickDirection(currentDirection, leftWheelSpeed, rightWheelSpeed); // Both wheels go backwards
                 goStraight = true;
-                leftWheelOpticalInterrupt = 0;
-                rightWheelOpticalInterrupt = 0;
                 actionHeldExecuted = true;
                 actionReleasedExecuted = false;
             }
@@ -631,12 +894,8 @@ void handleButtonAction(void)
             if (currentButtonState == BUTTON_HELD && !actionHeldExecuted)
             {
                 amRotate = true;
-                setDirection(0, 1023, 1023); // Both wheels go backwards
-                waitMicrosecond(100000);
-                setDirection(currentDirection, leftWheelSpeed, rightWheelSpeed); // Both wheels go backwards
+                kickDirection(currentDirection, leftWheelSpeed, rightWheelSpeed); // Both wheels go backwards
                 goStraight = true;
-                leftWheelOpticalInterrupt = 0;
-                rightWheelOpticalInterrupt = 0;
                 actionHeldExecuted = true;
                 actionReleasedExecuted = false;
             }
@@ -658,9 +917,7 @@ void handleButtonAction(void)
             if (currentButtonState == BUTTON_HELD && !actionHeldExecuted)
             {
                 amRotate = true;
-                setPwmDutyCycle(0, 0, 1023); // Left wheel moves backwards
-                waitMicrosecond(100000);
-                setPwmDutyCycle(0, 0, 850); // Left wheel moves backwards
+                kickWheel(0, 0, 850); // Left wheel moves backwards
                 actionHeldExecuted = true;
                 actionReleasedExecuted = false;
             }
@@ -676,9 +933,7 @@ void handleButtonAction(void)
             if (currentButtonState == BUTTON_HELD && !actionHeldExecuted)
             {
                 amRotate = true;
-                setPwmDutyCycle(0, 1023, 0); // Left wheel moves forward
-                waitMicrosecond(100000);
-                setPwmDutyCycle(0, 850, 0); // Left wheel moves forward
+                kickWheel(0, 850, 0); // Left wheel moves forward
                 actionHeldExecuted = true;
                 actionReleasedExecuted = false;
             }
@@ -694,9 +949,7 @@ void handleButtonAction(void)
             if (currentButtonState == BUTTON_HELD && !actionHeldExecuted)
             {
                 amRotate = true;
-                setPwmDutyCycle(1, 1023, 0); // Right wheel moves backwards
-                waitMicrosecond(100000);
-                setPwmDutyCycle(1, 850, 0); // Right wheel moves backwards
+                kickWheel(1, 850, 0); // Right wheel moves backwards
                 actionHeldExecuted = true;
                 actionReleasedExecuted = false;
             }
@@ -712,9 +965,7 @@ void handleButtonAction(void)
             if (currentButtonState == BUTTON_HELD && !actionHeldExecuted)
             {
                 amRotate = true;
-                setPwmDutyCycle(1, 0, 1023); // Right Wheel moves forward
-                waitMicrosecond(100000);
-                setPwmDutyCycle(1, 0, 850); // Right Wheel moves forward
+                kickWheel(1, 0, 850); // Right Wheel moves forward
                 actionHeldExecuted = true;
                 actionReleasedExecuted = false;
             }
@@ -737,8 +988,7 @@ void handleButtonAction(void)
             }
             else if (currentButtonState == BUTTON_RELEASED && !actionReleasedExecuted)
             {
-                amRotate = false;
-                turnOffAll();
+                // The turn finishes in checkMotionDone()
                 actionReleasedExecuted = true;
                 actionHeldExecuted = false;
             }
@@ -753,8 +1003,7 @@ void handleButtonAction(void)
             }
             else if (currentButtonState == BUTTON_RELEASED && !actionReleasedExecuted)
             {
-                amRotate = false;
-                turnOffAll();
+                // The turn finishes in checkMotionDone()
                 actionReleasedExecuted = true;
                 actionHeldExecuted = false;
             }
@@ -769,8 +1018,7 @@ void handleButtonAction(void)
             }
             else if (currentButtonState == BUTTON_RELEASED && !actionReleasedExecuted)
             {
-                amRotate = false;
-                turnOffAll();
+                // The turn finishes in checkMotionDone()
                 actionReleasedExecuted = true;
                 actionHeldExecuted = false;
             }
@@ -785,8 +1033,7 @@ void handleButtonAction(void)
             }
             else if (currentButtonState == BUTTON_RELEASED && !actionReleasedExecuted)
             {
-                amRotate = false;
-                turnOffAll();
+                // The turn finishes in checkMotionDone()
                 actionReleasedExecuted = true;
                 actionHeldExecuted = false;
             }
@@ -850,12 +1097,13 @@ void handleButtonAction(void)
                 goStraight = true;
                 goBalance = false;
                 setDirection(currentDirection, leftWheelSpeed, rightWheelSpeed);
-                WTIMER2_TAV_R = 0;
+                driveDeadline = deadlineIn(2000000);
+                timedDrive = true;
                 actionHeldExecuted = true;
             }
             else
             {
-                if ((WTIMER2_TAV_R/40000000) >= 2.0)
+                if (deadlinePassed(driveDeadline))
                 {
                     printfUart0("Finished Moving 1 Meter Forward \n");
                     goBalance = true;
@@ -874,12 +1122,13 @@ void handleButtonAction(void)
                 goStraight = true;
                 goBalance = false;
                 setDirection(currentDirection, leftWheelSpeed, rightWheelSpeed);
-                WTIMER2_TAV_R = 0;
+                driveDeadline = deadlineIn(2000000);
+                timedDrive = true;
                 actionHeldExecuted = true;
             }
             else
             {
-                if ((WTIMER2_TAV_R/40000000) >= 2.0)
+                if (deadlinePassed(driveDeadline))
                 {
                     printfUart0("Finished Moving 1 Meter Backward \n");
                     goBalance = true;
@@ -900,8 +1149,10 @@ void handleButtonAction(void)
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 volatile float currentRotation = 0.0;
+float rotateTarget = 0.0;
 
-void rotate(uint8_t degrees, bool direction) {
+// Starts turning, rotateReached() says when to stop
+void startRotate(uint8_t degrees, bool direction) {
     // Reset rotation angle
     currentRotation = 0.0;
 
@@ -917,17 +1168,21 @@ void rotate(uint8_t degrees, bool direction) {
         degrees -= 0;
     }
 
-    //printfUart0("currentGyroRotation = %f \n", &currentGyroRotation);
+    rotateTarget = degrees/3;
+}
+
+bool rotateReached(void)
+{
+    return fabs(currentRotation) >= rotateTarget;
+}
 
-    // Wait until the desired angle is reached
-    while (fabs(currentRotation) < (degrees/3))
-    {
-        //printfUart0("currentRotation = %f \n", &currentRotation);
-        //waitMicrosecond(10000); // 10ms
-    }
+// Returns once the turn has started, checkMotionDone() stops it at the angle
+void rotate(uint8_t degrees, bool direction) {
+    startRotate(degrees, direction);
+    rotateDeadline = deadlineIn(ROTATE_TIMEOUT_US);
+    rotating = true;
 
-    turnOffAll();
-    amRotate = false;
+    //printfUart0("currentGyroRotation = %f \n", currentGyroRotation);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -935,46 +1190,30 @@ void rotate(uint8_t degrees, bool direction) {
 // Left Wheel // OPB876N55 Optical Interrupter // PC6 // WT1CCP0
 void wideTimer1Isr()
 {
-    leftWheelOpticalInterrupt++;
-    leftWheelDistanceTraveled = leftWheelOpticalInterrupt;
-    //printfUart0("left Wheel Optical Interrupt:  %d \n", leftWheelOpticalInterrupt);
-    if(leftWheelOpticalInterrupt == 40) // 40 tabs on wheel // 1 tab detected = 1 cm
-    {
-        //rightWheelOpticalInterrupt = 0;
-        //printfUart0("left Wheel Full Rotation\n");
-    }
-    // 1m = 100cm = 2FullRotation + 20cm
+    PROFILE_MARK mark = profileEnter();
+    if (captureWheelEdge(&leftWheel, WTIMER1_TAR_R))
+        countWheelEdge(LEFT_WHEEL);              // 40 tabs on wheel // 1 tab detected = 1 cm
     WTIMER1_ICR_R = TIMER_ICR_CAECINT;           // clear interrupt flag
+    profileExit(PROFILE_WHEEL_LEFT, mark);
 }
 
 // Right Wheel // OPB876N55 Optical Interrupter // PD6 // WT5CCP0 // 1 tab detected = 1 cm
 void wideTimer5Isr()
 {
-    rightWheelOpticalInterrupt++;
-    rightWheelDistanceTraveled = rightWheelOpticalInterrupt;
-    //printfUart0("Right Wheel Optical Interrupt: %d \n", rightWheelOpticalInterrupt);
-    if(rightWheelOpticalInterrupt == 40) // 40 tabs on wheel
-    {
-        //rightWheelOpticalInterrupt = 0;
-        //printfUart0("Right Wheel Full Rotation\n");
-    }
-    // 1m = 100cm = 2FullRotation + 20cm
+    PROFILE_MARK mark = profileEnter();
+    if (captureWheelEdge(&rightWheel, WTIMER5_TAR_R))
+        countWheelEdge(RIGHT_WHEEL);
     WTIMER5_ICR_R = TIMER_ICR_CAECINT;
+    profileExit(PROFILE_WHEEL_RIGHT, mark);
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-float coeffKp = 2.2;  // Proportional coefficient // 2.5 is okay
-float coeffKi = 0; // Integral coefficient // should get me most of the way there // should be 1/100th to maybe 1/20th of kp
-float coeffKd = 0;   // Derivative coefficient
-
 int32_t integral = 0;
 int32_t iMax = 100; // 100
 
-int32_t prevLeftWheelOpticalInterrupt = 0;
-
-// Configure Timer 2 for PID controller (Driving Straight)
-void pidISR()
+// PID controller (Driving Straight) // scheduler task, 100 Hz
+void straightPID()
 {
     static float lastGyroError = 0;
     float gyroError;
@@ -982,6 +1221,8 @@ void pidISR()
     int32_t newLeftSpeed;
     int32_t newRightSpeed;
 
+    watchdogCheckIn(WATCHDOG_STRAIGHT);
+
     // Error is the rate of rotation around z axis
     gyroError = fgz; // deg/sec
     //gyroError = fgy; // deg/sec
@@ -1001,7 +1242,7 @@ void pidISR()
     if (integral < -iMax) integral = -iMax;
 
     float derivative = gyroError - lastGyroError;
-    output = coeffKp * gyroError + coeffKi * integral + coeffKd * derivative;
+    output = config.straightGains[0] * gyroError + config.straightGains[1] * integral + config.straightGains[2] * derivative;
 
     if (currentDirection == 1) // forward
     {
@@ -1012,27 +1253,23 @@ void pidISR()
         newRightSpeed = rightWheelSpeed - output;
     }
 
-    newLeftSpeed = MAX(MIN(newLeftSpeed, MAX_SPEED), MIN_SPEED);
-    newRightSpeed = MAX(MIN(newRightSpeed, MAX_SPEED), MIN_SPEED);
+    newLeftSpeed = MAX(MIN(newLeftSpeed, MAX_SPEED), (int32_t)config.minSpeed);
+    newRightSpeed = MAX(MIN(newRightSpeed, MAX_SPEED), (int32_t)config.minSpeed);
 
-    if (goStraight == true)
+    if ((goStraight == true) && !isMotorRampBusy()) // don't cut a kick short
     {
         setDirection(currentDirection, newLeftSpeed, newRightSpeed);
         /*
-        printfUart0("ax: %f  ay: %f  az: %f  gx: %f  gy: %f  gz: %f\n", &fax, &fay , &faz, &fgx, &fgy, &fgz);
+        printfUart0("ax: %f  ay: %f  az: %f  gx: %f  gy: %f  gz: %f\n", fax, fay , faz, fgx, fgy, fgz);
 
         printfUart0("Left = %d   Right = %d   ", newLeftSpeed, newRightSpeed);
-        printfUart0("Error = %f   LastError = %f   Integral = %d   ", &gyroError, &lastGyroError, integral);
-        printfUart0("derivative = %f   output = %d \n", &derivative, output);
+        printfUart0("Error = %f   LastError = %f   Integral = %d   ", gyroError, lastGyroError, integral);
+        printfUart0("derivative = %f   output = %d \n", derivative, output);
         waitMicrosecond(100000);
-        //printfUart0("LWOI = %d   RWOI = %d\n", leftWheelOpticalInterrupt, rightWheelOpticalInterrupt);
         */
     }
 
     lastGyroError = gyroError;
-
-    // Clear timer interrupt
-    TIMER2_ICR_R = TIMER_ICR_TATOCINT;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -1052,23 +1289,19 @@ void readMPU6050()
     gy = (data[10] << 8) | data[11];
     gz = (data[12] << 8) | data[13];
 
-    // Convert to g
-    fax = (ax/16384.0);
-    fay = (ay/16384.0);
-    faz = (az/16384.0);
+    // Convert to g, the trim levels the robot where it actually balances
+    fax = (ax/16384.0) - config.accelTrim[0];
+    fay = (ay/16384.0) - config.accelTrim[1];
+    faz = (az/16384.0) - config.accelTrim[2];
 
     // 2000 deg/sec
-    fgx = (gx/16.4);
-    fgy = (gy/16.4);
-    fgz = (gz/16.4);
+    fgx = (gx/16.4) - config.gyroBias[0];
+    fgy = (gy/16.4) - config.gyroBias[1];
+    fgz = (gz/16.4) - config.gyroBias[2];
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-float balanceKp = 2; // Proportional coefficient
-float balanceKi = 0; // Integral coefficient // should get me most of the way there // should be 1/100th to maybe 1/20th of kp
-float balanceKd = 0; // Derivative coefficient
-
 int32_t balanceIntegral = 0;
 int32_t balanceiMax = 100; // 100
 
@@ -1077,16 +1310,106 @@ float calculateTiltAngle()
     return atan2(fax, faz) * 180.0 / PI;
 }
 
-// Configure Timer 1 for PID controller (Balance)
+BalanceController balanceController = CONTROLLER_PID;
+float lqrHome = 0; // wheel position (m) the LQR holds, set when it is selected
+
+#define LQR_GYRO_SIGN  1.0   // set to -1.0 if gyro y has the opposite sign of the tilt
+#define LQR_DEADBAND   0.02  // commands smaller than this leave the motors off
+
+// Wheel position from the signed odometry counts in m
+float getWheelPosition()
+{
+    return (getWheelCount(LEFT_WHEEL) + getWheelCount(RIGHT_WHEEL)) / 2.0 * ODOMETRY_CM_PER_TAB / 100.0;
+}
+
+TELEMETRY_SAMPLE balanceSample;   // the scope reads tilt, pwm and pid from here
+
+// Every balance tick, for the scope, and every nth for telemetry
+// The rest of the sample is only filled on the ticks telemetry is due
+// PWM is what the balance loop commanded, negative backward, 0 when it didn't drive
+void sendBalanceTelemetry(float tiltAngle, int16_t leftPwm, int16_t rightPwm, float error, float integral, float derivative, float output)
+{
+    POSE pose;
+
+    balanceSample.tilt = tiltAngle;
+    balanceSample.pwm[0] = leftPwm;
+    balanceSample.pwm[1] = rightPwm;
+    balanceSample.pid[0] = error;
+    balanceSample.pid[1] = integral;
+    balanceSample.pid[2] = derivative;
+    balanceSample.pid[3] = output;
+    sampleScope();
+
+    if (!isTelemetryDue())
+        return;
+
+    pose = getPose();
+    balanceSample.gyro[0] = fgx;
+    balanceSample.gyro[1] = fgy;
+    balanceSample.gyro[2] = fgz;
+    balanceSample.accel[0] = fax;
+    balanceSample.accel[1] = fay;
+    balanceSample.accel[2] = faz;
+    balanceSample.count[0] = getWheelCount(LEFT_WHEEL);
+    balanceSample.count[1] = getWheelCount(RIGHT_WHEEL);
+    balanceSample.rate[0] = leftWheelRate;
+    balanceSample.rate[1] = rightWheelRate;
+    balanceSample.pose[0] = pose.x;
+    balanceSample.pose[1] = pose.y;
+    balanceSample.pose[2] = pose.theta;
+    sendTelemetrySample(&balanceSample);
+}
+
+// Full-state feedback alternative to the PID below, selected with "controller lqr"
+void balanceLQR(float tiltAngle)
+{
+    float state[LQR_STATES];
+    uint16_t pwm = 0;
+
+    state[LQR_TILT] = tiltAngle * PI / 180.0;
+    state[LQR_TILT_RATE] = LQR_GYRO_SIGN * fgy * PI / 180.0;
+    state[LQR_POSITION] = getWheelPosition() - lqrHome;
+    state[LQR_VELOCITY] = (leftWheelRate * getWheelSign(LEFT_WHEEL) + rightWheelRate * getWheelSign(RIGHT_WHEEL)) / 2 * ODOMETRY_CM_PER_TAB / 100.0;
+
+    float u = computeLqrOutput(state);
+
+    // The motors don't turn below the minimum speed, so map the command onto the usable range
+    if ((fabs(u) > LQR_DEADBAND) && (fabs(tiltAngle) < 80))
+        pwm = config.minSpeed + fabs(u) * (MAX_SPEED - config.minSpeed);
+
+    if ((goBalance == true) && (amRotate == false))
+    {
+        setDirection(u > 0, pwm, pwm);
+        sendBalanceTelemetry(tiltAngle, (u > 0) ? pwm : -pwm, (u > 0) ? pwm : -pwm, 0, 0, 0, u);
+    }
+    else
+    {
+        sendBalanceTelemetry(tiltAngle, 0, 0, 0, 0, 0, u);
+    }
+}
+
+// PID controller (Balance) // scheduler task, 40 Hz
 void balancePID()
 {
     static int32_t balanceLastError = 0;
 
     readMPU6050();
+    watchdogCheckIn(WATCHDOG_BALANCE); // the IMU answered
 
-    currentRotation += fgz * 0.025; // 25ms
+    leftWheelRate = updateWheelSpeed(&leftWheel, WTIMER1_TAV_R);
+    rightWheelRate = updateWheelSpeed(&rightWheel, WTIMER5_TAV_R);
+    updateOdometry(fgz, fax, BALANCE_PERIOD_MS / 1000.0);
+
+    currentRotation += fgz * BALANCE_PERIOD_MS / 1000.0;
 
     float tiltAngle = calculateTiltAngle();
+
+    if (balanceController == CONTROLLER_LQR)
+    {
+        balanceLQR(tiltAngle);
+        return;
+    }
+
     int32_t error = 0 - tiltAngle; // Desired angle is 0
 
     balanceIntegral += error;
@@ -1095,7 +1418,7 @@ void balancePID()
 
     int32_t derivative = error - balanceLastError;
 
-    int32_t output = balanceKp * error + balanceKi * balanceIntegral + balanceKd * derivative;
+    int32_t output = config.balanceGains[0] * error + config.balanceGains[1] * balanceIntegral + config.balanceGains[2] * derivative;
 
     // Base speed for balancing, may need to tweak this
     int32_t baseSpeed = 800;
@@ -1112,8 +1435,8 @@ void balancePID()
     int32_t newLeftSpeed = (direction ? leftWheelSpeed + output : leftWheelSpeed - output);
     int32_t newRightSpeed = (direction ? rightWheelSpeed + output : rightWheelSpeed - output);
 
-    newLeftSpeed = MAX(MIN(newLeftSpeed, MAX_SPEED), MIN_SPEED);
-    newRightSpeed = MAX(MIN(newRightSpeed, MAX_SPEED), MIN_SPEED);
+    newLeftSpeed = MAX(MIN(newLeftSpeed, MAX_SPEED), (int32_t)config.minSpeed);
+    newRightSpeed = MAX(MIN(newRightSpeed, MAX_SPEED), (int32_t)config.minSpeed);
 
     float balanceThreshold = 20.0; // Adjust
     if (((fabs(tiltAngle) < balanceThreshold) || (fabs(tiltAngle) > 80)) && (amRotate == false)) // the robot seems to currently tilt a bit forward when balanced so maybe change the conditions here
@@ -1125,7 +1448,7 @@ void balancePID()
     {
         setDirection(direction, newLeftSpeed, newRightSpeed);
         /*
-        printfUart0("ax: %f  ay: %f  az: %f  gx: %f  gy: %f  gz: %f  Tilt Angle = %f\n", &fax, &fay , &faz, &fgx, &fgy, &fgz, &tiltAngle);
+        printfUart0("ax: %f  ay: %f  az: %f  gx: %f  gy: %f  gz: %f  Tilt Angle = %f\n", fax, fay , faz, fgx, fgy, fgz, tiltAngle);
 
         printfUart0("Left = %d   Right = %d   ", newLeftSpeed, newRightSpeed);
         printfUart0("Error = %d   LastError = %d   Integral = %d   ", error, balanceLastError, balanceIntegral);
@@ -1133,12 +1456,15 @@ void balancePID()
         waitMicrosecond(100000);
         */
         //printfUart0("Left = %d   Right = %d\n", newLeftSpeed, newRightSpeed);
+        sendBalanceTelemetry(tiltAngle, direction ? newLeftSpeed : -newLeftSpeed, direction ? newRightSpeed : -newRightSpeed,
+                             error, balanceIntegral, derivative, output);
+    }
+    else
+    {
+        sendBalanceTelemetry(tiltAngle, 0, 0, error, balanceIntegral, derivative, output);
     }
 
     balanceLastError = error;
-
-    // Clear timer interrupt
-    TIMER1_ICR_R = TIMER_ICR_TATOCINT;
 }
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -1148,7 +1474,7 @@ void initMPU6050()
 {
     // Wake up the MPU6050 - write 0
     writeI2c1Register(MPU6050, 0x6B, 0x00);
-    waitMicrosecond(10000);
+    delayUs(10000);
 
     // Set sensitivity to 2g
     // 0x00 for +/- 2g
@@ -1166,16 +1492,666 @@ void initMPU6050()
 }
 
 
+//-----------------------------------------------------------------------------
+// Tasks
+//-----------------------------------------------------------------------------
+
+// Rate groups, ticks are 1 ms
+const TASK taskTable[] =
+{
+    // name        function         period  phase  priority
+    { "balance",   balancePID,      BALANCE_PERIOD_MS, 0, SCHEDULER_PRIORITY_TICK },
+    { "straight",  straightPID,     10,     3,     1 },
+    { "ir",        checkIrRelease,  20,     7,     2 },
+    { "motor",     updateMotorRamp, 10,     1,     1 },
+    { "profile",   takeProfileSnapshot, PROFILE_SNAPSHOT_MS, 11, 3 },
+    { "watchdog",  serviceWatchdog, 100,    13,    3 },
+    { "motion",    checkMotionDone, 10,     5,     2 },
+    { "telemetry", sendTelemetryTiming, 125, 17,   3 },
+};
+
+//-----------------------------------------------------------------------------
+// Commands
+//-----------------------------------------------------------------------------
+
+void angleCommand(USER_DATA* data)
+{
+    printfUart0("currentGyroRotation = %f \n", currentGyroRotation);
+}
+
+void clearCommand(USER_DATA* data)
+{
+    printfUart0("currentGyroRotation Cleared \n");
+    currentGyroRotation = 0;
+}
+
+void poseCommand(USER_DATA* data)
+{
+    POSE pose = getPose();
+    float theta = pose.theta * 180.0 / PI;
+    int32_t left = getWheelCount(LEFT_WHEEL);
+    int32_t right = getWheelCount(RIGHT_WHEEL);
+
+    if (data->fieldCount > 1 && customStrcmp("clear", getFieldString(data, 1)))
+    {
+        resetPose();
+        printfUart0("Pose Cleared \n");
+    }
+    else
+    {
+        printfUart0("x = %f cm   y = %f cm   ", pose.x, pose.y);
+        printfUart0("theta = %f degrees   ", theta);
+        printfUart0("left = %d   right = %d tabs\n", left, right);
+    }
+}
+
+void slipCommand(USER_DATA* data)
+{
+    SLIP_COUNTERS counters = getSlipCounters();
+    uint8_t flags = getSlipFlags();
+
+    if (data->fieldCount > 1 && customStrcmp("clear", getFieldString(data, 1)))
+    {
+        clearSlipCounters();
+        printfUart0("Slip Counters Cleared \n");
+    }
+    else
+    {
+        printfUart0("slip = %u   stall L/R = %u/%u   ", counters.slip, counters.stall[LEFT_WHEEL], counters.stall[RIGHT_WHEEL]);
+        printfUart0("glitch L/R = %u/%u   ", counters.glitch[LEFT_WHEEL], counters.glitch[RIGHT_WHEEL]);
+        printfUart0("edge glitch L/R = %u/%u   ", leftWheel.glitchCount, rightWheel.glitchCount);
+        printfUart0("flags = 0x%x\n", flags);
+    }
+}
+
+void controllerCommand(USER_DATA* data)
+{
+    char* str = getFieldString(data, 1);
+
+    if(customStrcmp("pid", str))
+    {
+        balanceController = CONTROLLER_PID;
+        printfUart0("Balance Controller = PID \n");
+    }
+    else if(customStrcmp("lqr", str))
+    {
+        lqrHome = getWheelPosition();
+        balanceController = CONTROLLER_LQR;
+        printfUart0("Balance Controller = LQR \n");
+    }
+    else
+    {
+        printCommandUsage();
+    }
+}
+
+void timingCommand(USER_DATA* data)
+{
+    uint8_t i;
+
+    if (data->fieldCount > 1 && customStrcmp("clear", getFieldString(data, 1)))
+    {
+        for (i = 0; i < getTaskCount(); i++)
+        {
+            clearTaskTiming(i);
+            clearTaskOverruns(i);
+        }
+        printfUart0("Timing Cleared \n");
+        return;
+    }
+
+    for (i = 0; i < getTaskCount(); i++)
+    {
+        printTaskTiming(i);
+        printfUart0("  overruns %u\n", getTaskOverruns(i));
+    }
+}
+
+void parkCommand(USER_DATA* data)
+{
+    printfUart0("Parked, IR, a key or a button wakes me\n");
+    park();
+    printfUart0("Awake\n");
+    printPowerStats();
+}
+
+void powerCommand(USER_DATA* data)
+{
+    if (data->fieldCount > 1 && customStrcmp("clear", getFieldString(data, 1)))
+    {
+        clearPowerStats();
+        printfUart0("Power Cleared \n");
+    }
+    else
+    {
+        printPowerStats();
+    }
+}
+
+void memCommand(USER_DATA* data)
+{
+    printStackUsage();
+}
+
+void telemetryCommand(USER_DATA* data)
+{
+    if (data->fieldCount > 1 && customStrcmp("on", getFieldString(data, 1)))
+        enableTelemetry(true);
+    else if (data->fieldCount > 1 && customStrcmp("off", getFieldString(data, 1)))
+        enableTelemetry(false);
+    else if (data->fieldCount > 2 && customStrcmp("rate", getFieldString(data, 1)))
+        setTelemetryDivider(getFieldInteger(data, 2));
+    else if (data->fieldCount > 2 && customStrcmp("channels", getFieldString(data, 1)))
+        setTelemetryChannels(getFieldInteger(data, 2));
+    else if (data->fieldCount > 1)
+        printCommandUsage();
+    printTelemetryStatus();
+}
+
+void uartCommand(USER_DATA* data)
+{
+    UART0_STATS u;
+
+    if (data->fieldCount > 1 && customStrcmp("drop", getFieldString(data, 1)))
+        setUart0TxPolicy(UART0_TX_DROP);
+    else if (data->fieldCount > 1 && customStrcmp("block", getFieldString(data, 1)))
+        setUart0TxPolicy(UART0_TX_BLOCK);
+    else if (data->fieldCount > 1)
+        printCommandUsage();
+    u = getUart0Stats();
+    printfUart0("tx queued %u   max %u of %u   dropped %u\n", getUart0TxQueued(), u.txMaxQueued, UART0_TX_BUFFER_SIZE, u.txDropped);
+    printfUart0("rx dropped %u   errors %u\n", u.rxDropped, u.rxErrors);
+}
+
+void baudCommand(USER_DATA* data)
+{
+    UART0_BAUD baud;
+
+    if (data->fieldCount > 1)
+    {
+        startBaudChange(getFieldInteger(data, 1));
+    }
+    else
+    {
+        baud = getUart0Baud();
+        printBaud(&baud);
+    }
+}
+
+void okCommand(USER_DATA* data)
+{
+    if (baudFallback != 0)
+    {
+        baudFallback = 0;
+        printfUart0("baud %u confirmed\n", getUart0Baud().requested);
+    }
+    else
+    {
+        printfUart0("no baud change to confirm\n");
+    }
+}
+
+void eventsCommand(USER_DATA* data)
+{
+    EVENT_STATS e = getEventStats();
+    printfUart0("events posted %u   dropped %u   max queued %u of %u\n", e.posted, e.dropped, e.maxDepth, EVENT_QUEUE_LENGTH);
+}
+
+void topCommand(USER_DATA* data)
+{
+    uint8_t seconds = (data->fieldCount > 1) ? getFieldInteger(data, 1) : 5;
+    printProfile(seconds);
+}
+
+void latencyCommand(USER_DATA* data)
+{
+    if (data->fieldCount > 1 && customStrcmp("clear", getFieldString(data, 1)))
+    {
+        clearTickLatency();
+        printfUart0("Latency Cleared \n");
+    }
+    else if (data->fieldCount > 1 && customStrcmp("test", getFieldString(data, 1)))
+    {
+        uint32_t seconds = (data->fieldCount > 2) ? getFieldInteger(data, 2) : LATENCY_DEFAULT_SECONDS;
+        uint32_t loadUs = (data->fieldCount > 3) ? getFieldInteger(data, 3) : LATENCY_DEFAULT_LOAD_US;
+        printfUart0("Latency test, %u s, %u us load interrupts\n", seconds, loadUs);
+        startLatencyTest(seconds, loadUs);
+    }
+    else if (data->fieldCount > 1)
+    {
+        printCommandUsage();
+    }
+    else
+    {
+        printTickLatency();
+    }
+}
+
+void tiltCommand(USER_DATA* data)
+{
+    float currentTilt = calculateTiltAngle();
+    printfUart0("current Tilt = %f degrees\n", currentTilt);
+}
+
+// Timed straight move, 1 = forward, negative distances go the other way
+void driveDistance(uint16_t direction, float meters)
+{
+    if (meters < 0)
+    {
+        meters = -meters;
+        direction = !direction;
+    }
+    amRotate = true;
+    leftWheelSpeed = 850;
+    rightWheelSpeed = 850;
+    currentDirection = direction;
+    kickDirection(currentDirection, leftWheelSpeed, rightWheelSpeed);
+    goStraight = true;
+    driveDeadline = deadlineIn(DRIVE_US_PER_M * meters);
+    timedDrive = true;
+}
+
+// Distance argument in m, 1 m if there is none
+// Returns false after printing the usage if it is out of range
+bool getDriveMeters(USER_DATA* data, float* meters)
+{
+    *meters = 1.0;
+    if (data->fieldCount > 1)
+    {
+        *meters = getFieldNumber(data, 1);
+        if (getFieldUnit(data, 1) == UNIT_CM)
+            *meters /= 100;
+    }
+    if (*meters > DRIVE_MAX_M || *meters < -DRIVE_MAX_M)
+    {
+        printCommandUsage();
+        return false;
+    }
+    return true;
+}
+
+// Script moves // called from the motion task
+void scriptDrive(float meters)
+{
+    driveDistance(1, meters);
+}
+
+void scriptRotate(int16_t degrees)
+{
+    rotate((degrees < 0) ? -degrees : degrees, degrees < 0);
+}
+
+bool scriptIsMoving()
+{
+    return timedDrive || rotating || goStraight || amRotate;
+}
+
+const SCRIPT_MOTION scriptMotion = { scriptDrive, scriptRotate, stopMotion, scriptIsMoving, calculateTiltAngle };
+
+void scopeCommand(USER_DATA* data)
+{
+    char* str = getFieldString(data, 1);
+    char* condition;
+    bool ok = true;
+
+    if (data->fieldCount == 1)
+    {
+        printScopeStatus();
+        return;
+    }
+
+    if (customStrcmp("arm", str))
+    {
+        ok = armScope();
+        if (!ok)
+            printfUart0("no channels, or the window doesn't fit\n");
+    }
+    else if (customStrcmp("stop", str))
+        stopScope();
+    else if (customStrcmp("force", str))
+        forceScopeTrigger();
+    else if (customStrcmp("dump", str))
+    {
+        if (startScopeDump())
+            postEvent(EVENT_SCOPE_DUMP, 0);
+        else
+            printfUart0("no capture\n");
+        return;
+    }
+    else if (customStrcmp("add", str) && data->fieldCount == 3)
+        ok = addScopeChannel(getFieldString(data, 2));
+    else if (customStrcmp("clear", str))
+        ok = clearScopeChannels();
+    else if (customStrcmp("rate", str) && data->fieldCount == 3 && data->fieldType[2] == 'n')
+        ok = setScopeDecimation(getFieldInteger(data, 2));
+    else if (customStrcmp("window", str) && data->fieldCount == 4 && data->fieldType[2] == 'n' && data->fieldType[3] == 'n'
+             && getFieldInteger(data, 2) >= 0 && getFieldInteger(data, 3) >= 0)
+        ok = setScopeWindow(getFieldInteger(data, 2), getFieldInteger(data, 3));
+    else if (customStrcmp("trigger", str) && data->fieldCount == 3 && customStrcmp("off", getFieldString(data, 2)))
+        ok = clearScopeTrigger();
+    else if (customStrcmp("trigger", str) && data->fieldCount == 5 && data->fieldType[4] != 'a')
+    {
+        condition = getFieldString(data, 3);
+        if (customStrcmp("above", condition))
+            ok = setScopeTrigger(getFieldString(data, 2), SCOPE_ABOVE, getFieldNumber(data, 4));
+        else if (customStrcmp("below", condition))
+            ok = setScopeTrigger(getFieldString(data, 2), SCOPE_BELOW, getFieldNumber(data, 4));
+        else if (customStrcmp("outside", condition))
+            ok = setScopeTrigger(getFieldString(data, 2), SCOPE_OUTSIDE, getFieldNumber(data, 4));
+        else
+        {
+            printCommandUsage();
+            return;
+        }
+    }
+    else
+    {
+        printCommandUsage();
+        return;
+    }
+
+    if (!ok)
+        printfUart0("not while armed, or no such variable\n");
+    printScopeStatus();
+}
+
+void printConfig()
+{
+    uint8_t i;
+
+    printConfigStatus();
+    for (i = 0; i < sizeof(configFields) / sizeof(configFields[0]); i++)
+        printfUart0("  %s %.3f%s", configFields[i].name, *configFields[i].value, (i % 3 == 2) ? "\n" : "");
+    printfUart0("  minspeed %u\n", config.minSpeed);
+}
+
+void printIrCodes()
+{
+    uint8_t i;
+
+    for (i = 0; i < CONFIG_IR_KEYS; i++)
+        printfUart0("  %s %u%s\n", irKeyNames[i], config.irCodes[i], (config.irCodes[i] == irKeyActions[i]) ? "" : " (learned)");
+    printfUart0("  last code received %u\n", lastDecodedData);
+}
+
+// IR codes use all 32 bits, more than getFieldInteger() holds, so the text is read again
+// Decimal or 0x hex, false if it isn't a number or doesn't fit
+bool getFieldCode(USER_DATA* data, uint8_t field, uint32_t* code)
+{
+    char* str = getFieldString(data, field);
+    uint32_t base = 10;
+    uint32_t digit;
+    uint64_t value = 0;
+
+    if (str[0] == '0' && (str[1] == 'x' || str[1] == 'X'))
+    {
+        base = 16;
+        str += 2;
+    }
+    if (*str == '\0')
+        return false;
+    for (; *str != '\0'; str++)
+    {
+        if (*str >= '0' && *str <= '9')
+            digit = *str - '0';
+        else if (base == 16 && (*str | 0x20) >= 'a' && (*str | 0x20) <= 'f')
+            digit = (*str | 0x20) - 'a' + 10;
+        else
+            return false;
+        value = value * base + digit;
+        if (value > 0xFFFFFFFF)
+            return false;
+    }
+    *code = value;
+    return true;
+}
+
+// Changes the gains and calibration in RAM, "save" keeps them
+void configCommand(USER_DATA* data)
+{
+    char* name = getFieldString(data, 1);
+    uint32_t code;
+    uint8_t i;
+
+    if (data->fieldCount == 1)
+    {
+        printConfig();
+        return;
+    }
+
+    if (customStrcmp("ir", name))
+    {
+        if (data->fieldCount == 2)
+        {
+            printIrCodes();
+            return;
+        }
+        for (i = 0; i < CONFIG_IR_KEYS; i++)
+            if (customStrcmp(irKeyNames[i], getFieldString(data, 2)))
+                break;
+        // Without a code the key takes the last one the receiver decoded
+        code = lastDecodedData;
+        if (i == CONFIG_IR_KEYS || (data->fieldCount == 4 && !getFieldCode(data, 3, &code)))
+        {
+            printCommandUsage();
+            return;
+        }
+        config.irCodes[i] = code;
+        printfUart0("%s = %u\n", irKeyNames[i], config.irCodes[i]);
+        return;
+    }
+
+    if (data->fieldCount != 3 || data->fieldType[2] == 'a')
+    {
+        printCommandUsage();
+        return;
+    }
+    if (customStrcmp("minspeed", name))
+    {
+        if (data->fieldType[2] != 'n' || getFieldInteger(data, 2) < 0 || getFieldInteger(data, 2) > MAX_SPEED)
+        {
+            printCommandUsage();
+            return;
+        }
+        config.minSpeed = getFieldInteger(data, 2);
+        printConfig();
+        return;
+    }
+    for (i = 0; i < sizeof(configFields) / sizeof(configFields[0]); i++)
+    {
+        if (customStrcmp(configFields[i].name, name))
+        {
+            *configFields[i].value = getFieldNumber(data, 2);
+            printConfig();
+            return;
+        }
+    }
+    printCommandUsage();
+}
+
+// The control loops read config every tick, they get the new one in one piece
+void applyConfig(const CONFIG* newConfig)
+{
+    uint32_t primask = _disable_interrupts();
+    config = *newConfig;
+    _restore_interrupts(primask);
+}
+
+// An EEPROM word takes milliseconds to write and stalls flash reads meanwhile,
+// the control loops would miss ticks with the motors on
+bool canWriteConfig()
+{
+    if (goBalance || scriptIsMoving() || isScriptRunning())
+    {
+        printfUart0("not while balancing or moving, push button 2 turns balancing off\n");
+        return false;
+    }
+    return true;
+}
+
+void saveCommand(USER_DATA* data)
+{
+    if (canWriteConfig())
+        printfUart0("config %s\n", getConfigResultName(saveConfig(&config)));
+}
+
+void loadCommand(USER_DATA* data)
+{
+    CONFIG loaded;
+
+    loadConfig(&loaded);
+    applyConfig(&loaded);
+    printConfig();
+}
+
+void factoryCommand(USER_DATA* data)
+{
+    if (!canWriteConfig())
+        return;
+    applyConfig(&defaultConfig);
+    printfUart0("defaults, config %s\n", getConfigResultName(saveConfig(&config)));
+}
+
+void scriptCommand(USER_DATA* data)
+{
+    SCRIPT_STATUS status = getScriptStatus();
+    char* str = getFieldString(data, 1);
+
+    if (data->fieldCount == 1)
+    {
+        printfUart0("script %s, %u steps, %u runs", scriptStateNames[status.state], status.steps, status.runs);
+        if (status.state == SCRIPT_RUNNING)
+            printfUart0(", step %u, abort at %.1f deg", status.step, status.abortTilt);
+        printfUart0("\n");
+    }
+    else if (customStrcmp("load", str))
+    {
+        if (status.state == SCRIPT_RUNNING)
+        {
+            printfUart0("script is running, stop it first\n");
+            return;
+        }
+        beginScriptLoad();
+        printfUart0("send up to %u steps, done to finish\n", SCRIPT_MAX_STEPS);
+    }
+    else if (customStrcmp("run", str))
+    {
+        if (!startScript())
+            printfUart0((status.state == SCRIPT_RUNNING) ? "script is running\n" : "no script loaded\n");
+    }
+    else if (customStrcmp("stop", str))
+    {
+        stopScript();
+        printfUart0("Script stopped\n");
+    }
+    else if (customStrcmp("list", str))
+    {
+        printScript();
+    }
+    else
+    {
+        printCommandUsage();
+    }
+}
+
+void forwardCommand(USER_DATA* data)
+{
+    float meters;
+
+    if (getDriveMeters(data, &meters))
+        driveDistance(1, meters); // Both wheels go forwards
+}
+
+void reverseCommand(USER_DATA* data)
+{
+    float meters;
+
+    if (getDriveMeters(data, &meters))
+        driveDistance(0, meters); // Both wheels go backwards
+}
+
+void rotateCommand(USER_DATA* data)
+{
+    char* str = getFieldString(data, 1);
+    int32_t degrees = (data->fieldCount > 2) ? getFieldNumber(data, 2) : 90;
+    bool ccw = false;
+
+    if(customStrcmp("cw", str))
+        ccw = false;
+    else if(customStrcmp("ccw", str))
+        ccw = true;
+    else
+        degrees = 0;
+
+    // A negative angle turns the other way
+    if (degrees < 0)
+    {
+        degrees = -degrees;
+        ccw = !ccw;
+    }
+    if (degrees == 0 || degrees > ROTATE_MAX_DEG)
+    {
+        printCommandUsage();
+        return;
+    }
+
+    rotate(degrees, ccw);
+}
+
+// Lookup is through commandHash.h, run tools/command_hash.py after changing the names or their order
+const COMMAND commandTable[] =
+{
+    // name          args  types  handler            usage                                  help
+    { "angle",       0, 0, "",    angleCommand,      "angle",                               "rotation from the gyro since power-on or clear (deg)" },
+    { "clear",       0, 0, "",    clearCommand,      "clear",                               "zero the rotation angle" },
+    { "tilt",        0, 0, "",    tiltCommand,       "tilt",                                "angle from vertical (deg)" },
+    { "forward",     0, 1, "d",   forwardCommand,    "forward [distance, m or cm]",         "drive forward, 1 m if no distance is given" },
+    { "reverse",     0, 1, "d",   reverseCommand,    "reverse [distance, m or cm]",         "drive backward, 1 m if no distance is given" },
+    { "rotate",      1, 2, "wa",  rotateCommand,     "rotate cw|ccw [deg]",                 "turn, 90 degrees if no angle is given" },
+    { "pose",        0, 1, "w",   poseCommand,       "pose [clear]",                        "dead-reckoning position and wheel counts" },
+    { "slip",        0, 1, "w",   slipCommand,       "slip [clear]",                        "wheel slip, stall and glitch counters" },
+    { "controller",  1, 1, "w",   controllerCommand, "controller pid|lqr",                  "select the balance controller" },
+    { "timing",      0, 1, "w",   timingCommand,     "timing [clear]",                      "execution time, jitter and misses per task" },
+    { "top",         0, 1, "i",   topCommand,        "top [s]",                             "CPU load per task over the last 1 to 8 s" },
+    { "mem",         0, 0, "",    memCommand,        "mem",                                 "stack high-water mark" },
+    { "latency",     0, 3, "wii", latencyCommand,    "latency [clear|test [s] [us]]",       "balance tick entry latency, or test it under load" },
+    { "park",        0, 0, "",    parkCommand,       "park",                                "motors off, sleep until IR, a key or a button" },
+    { "power",       0, 1, "w",   powerCommand,      "power [clear]",                       "time asleep and wake-up cost" },
+    { "events",      0, 0, "",    eventsCommand,     "events",                              "event queue counters" },
+    { "uart",        0, 1, "w",   uartCommand,       "uart [drop|block]",                   "ring fill and drops, or what a full ring does" },
+    { "baud",        0, 1, "i",   baudCommand,       "baud [n]",                            "show the rate, or switch and wait for ok" },
+    { "ok",          0, 0, "",    okCommand,         "ok",                                  "confirm a baud change at the new rate" },
+    { "scope",       0, 4, "w???", scopeCommand,     "scope [arm|stop|force|dump|add v|clear|rate n|window pre post|trigger v above|below|outside x|trigger off]", "capture variables around a trigger" },
+    { "config",      0, 3, "w??", configCommand,     "config [name value|ir [key [code]]]", "gains and calibration, a key without a code learns the last one received" },
+    { "save",        0, 0, "",    saveCommand,       "save",                                "keep the config over resets" },
+    { "load",        0, 0, "",    loadCommand,       "load",                                "go back to the saved config" },
+    { "factory",     0, 0, "",    factoryCommand,    "factory",                             "save the default config" },
+    { "script",      0, 1, "w",   scriptCommand,     "script [load|run|stop|list]",         "upload, run and stop motion scripts" },
+    { "telemetry",   0, 2, "wi",  telemetryCommand,  "telemetry [on|off|rate n|channels n]", "binary telemetry stream" },
+    { "help",        0, 1, "w",   helpCommand,       "help [command]",                      "this list, or one command" },
+};
+
 //-----------------------------------------------------------------------------
 // Main
 //-----------------------------------------------------------------------------
 
 int main(void)
 {
+    // Before anything deep runs
+    initStackMonitor();
+
     // Initialize hardware
     initHw();
+    initPriorities();
+    initCrash();
     initUart0();
-    setUart0BaudRate(115200, 40e6);
+    setUart0BaudRate(115200, SYSTEM_CLOCK_HZ);
+
+    // Gains and calibration have to be in place before the control loops start
+    initEeprom();
+    initConfig(&defaultConfig);
+    loadConfig(&config);
+
     enableTimerMode();
     initPWM();
 
@@ -1184,6 +2160,11 @@ int main(void)
     turnOffAll();
 
     printfUart0("\n\nInitialization Success\n\n");
+    printfUart0("Config: %s\n", getConfigResultName(getConfigStatus().lastResult));
+
+    // Task names are needed for the crash report, the tick starts later
+    initScheduler(taskTable, sizeof(taskTable) / sizeof(taskTable[0]));
+    reportCrash(reportResetCause());
 
     initI2c1();
 
@@ -1202,111 +2183,114 @@ int main(void)
     // START condition (S) on the bus, which is defined as a HIGH-to-LOW transition of the SDA line while SCL line is HIGH
     initMPU6050();
 
+    // Start the control loops once the IMU is up
+    initTelemetry();
+    startScheduler();
+    clearPowerStats();
+
+    // Motors are cut if a control task or the main loop stops checking in
+    setUart0WaitHook(checkInMain);
+    initWatchdog();
+
+    // Typed characters, buttons, IR codes and finished moves arrive as events
+    initEvents();
+    initLineEditor();
+    initCommands(commandTable, sizeof(commandTable) / sizeof(commandTable[0]));
+    initScript(&scriptMotion);
+    setUart0RxHook(uartRxReady);
+    setUart0TxLowHook(uartTxLow);
+    enableUart0RxInterrupt();
+    selectPinInterruptFallingEdge(PB_1);
+    selectPinInterruptFallingEdge(PB_2);
+    clearPinInterrupt(PB_1);
+    clearPinInterrupt(PB_2);
+    enablePinInterrupt(PB_1);
+    enablePinInterrupt(PB_2);
+    buttonQuiet = deadlineIn(0);
+    NVIC_EN0_R = 1 << (INT_GPIOF-16);                // UART0 is on since initUart0()
+
+    // Scope variables, sampled every balance tick, and what a fall needs
+    initScope(BALANCE_PERIOD_MS * 1000);
+    registerScopeVariable("tilt", &balanceSample.tilt, SCOPE_FLOAT);
+    registerScopeVariable("gx", &fgx, SCOPE_FLOAT);
+    registerScopeVariable("gy", &fgy, SCOPE_FLOAT);
+    registerScopeVariable("gz", &fgz, SCOPE_FLOAT);
+    registerScopeVariable("ax", &fax, SCOPE_FLOAT);
+    registerScopeVariable("ay", &fay, SCOPE_FLOAT);
+    registerScopeVariable("az", &faz, SCOPE_FLOAT);
+    registerScopeVariable("pwmL", &balanceSample.pwm[0], SCOPE_INT16);
+    registerScopeVariable("pwmR", &balanceSample.pwm[1], SCOPE_INT16);
+    registerScopeVariable("error", &balanceSample.pid[0], SCOPE_FLOAT);
+    registerScopeVariable("integral", &balanceSample.pid[1], SCOPE_FLOAT);
+    registerScopeVariable("deriv", &balanceSample.pid[2], SCOPE_FLOAT);
+    registerScopeVariable("output", &balanceSample.pid[3], SCOPE_FLOAT);
+    registerScopeVariable("rateL", &leftWheelRate, SCOPE_FLOAT);
+    registerScopeVariable("rateR", &rightWheelRate, SCOPE_FLOAT);
+    registerScopeVariable("speedL", &leftWheelSpeed, SCOPE_UINT16);
+    registerScopeVariable("speedR", &rightWheelSpeed, SCOPE_UINT16);
+    registerScopeVariable("rotation", &currentRotation, SCOPE_FLOAT);
+    addScopeChannel("tilt");
+    addScopeChannel("gy");
+    addScopeChannel("pwmL");
+    addScopeChannel("pwmR");
+    setScopeWindow(8, 32);      // 200 ms before, 800 ms after
+    setScopeTrigger("tilt", SCOPE_OUTSIDE, 30);
+
     USER_DATA data;
-    char str[80];
-    bool valid = false;
+    PROFILE_MARK mark;
+    EVENT event;
+
+    markMainStack();
 
     while (true)
     {
-        if((WTIMER3_TAV_R / 40) > 200000)
-        {
-            currentButtonState = BUTTON_RELEASED;
-            //currentButtonAction = NONE; // this breaks the code
+        checkInMain();
+        checkBaudChange();
 
-            //leftWheelOpticalInterrupt = 0;
-            //rightWheelOpticalInterrupt = 0;
-            //goStraight = false;
+        // The latency test feeds the UART every pass
+        if (isLatencyTestRunning())
+        {
+            mark = profileEnter();
+            updateLatencyTest();
+            profileExit(PROFILE_MAIN, mark);
         }
 
-        handleButtonAction();
-
-        if(kbhitUart0())
+        if (!getEvent(&event))
         {
-            putsUart0(" > ");
-            valid = false;
+            // Nothing to do until the next interrupt
+            if (!isLatencyTestRunning())
+                idleSleep();
+            continue;
+        }
 
-            getsUart0(&data);
-            putsUart0(data.buffer);
+        if (event.type != EVENT_UART_RX)
+        {
+            mark = profileEnter();
+            dispatchEvent(&event);
+            profileExit(PROFILE_MAIN, mark);
+            continue;
+        }
 
-            // Parse fields
+        // Echo what has been typed so far, a finished line runs as a command
+        mark = profileEnter();
+        uartEventQueued = false;
+        if (updateLineEditor(&data))
+        {
+            // Parse fields, the trace gets the line before it is split
+            traceText(TRACE_CLI, data.buffer);
             parseFields(&data);
 
-            if (isCommand(&data, "angle", 0))
-            {
-                printfUart0("currentGyroRotation = %f \n", &currentGyroRotation);
-            }
-
-            if (isCommand(&data, "clear", 0))
-            {
-                printfUart0("currentGyroRotation Cleared \n");
-                currentGyroRotation = 0;
-            }
-
-            // alarm_pulse min max
-            if (isCommand(&data, "tilt", 0))
-            {
-                float currentTilt = calculateTiltAngle();
-                printfUart0("current Tilt = %f degrees\n", &currentTilt);
-            }
-
-            if (isCommand(&data, "forward", 0))
-            {
-                amRotate = true;
-                setDirection(1, 1023, 1023); // Both wheels go forwards
-                waitMicrosecond(100000);
-                leftWheelSpeed = 850;
-                rightWheelSpeed = 850;
-                currentDirection = 1;
-                setDirection(currentDirection, leftWheelSpeed, rightWheelSpeed); // Both wheels go forwards
-                goStraight = true;
-                waitMicrosecond(2500000);
-                goStraight = false;
-                amRotate = false;
-                turnOffAll();
-            }
-
-            if (isCommand(&data, "reverse", 0))
-            {
-                amRotate = true;
-                setDirection(0, 1023, 1023); // Both wheels go forwards
-                waitMicrosecond(100000);
-                leftWheelSpeed = 850;
-                rightWheelSpeed = 850;
-                currentDirection = 0;
-                setDirection(currentDirection, leftWheelSpeed, rightWheelSpeed); // Both wheels go forwards
-                goStraight = true;
-                waitMicrosecond(2500000);
-                goStraight = false;
-                amRotate = false;
-                turnOffAll();
-            }
-
-            if (isCommand(&data, "rotate", 1))
-            {
-                char* str = getFieldString(&data, 1);
-                valid = true;
-
-                if(customStrcmp("cw", str))
-                {
-                    amRotate = true;
-                    rotate(90, false);
-                    amRotate = false;
-                    turnOffAll();
-                }
-                else if(customStrcmp("ccw", str))
-                {
-                    amRotate = true;
-                    rotate(90, true);
-                    amRotate = false;
-                    turnOffAll();
-                }
-            }
+            // While a script uploads its lines are steps, not commands
+            if (isScriptLoading())
+                addScriptLine(&data);
+            else
+                dispatchCommand(&data);
 
-            if (!valid)
-            {
-                //putsUart0("\nInvalid command\n");
-            }
+            // Lines pasted in one go wait behind this one
+            if (kbhitUart0() && !uartEventQueued)
+                uartEventQueued = postEvent(EVENT_UART_RX, 0);
         }
+        profileExit(PROFILE_CLI, mark);
 
         //If angle is received, the current angle of rotation, relative to the power-on setting or the last clear
 
@@ -7,7 +7,7 @@
 
 // Target Platform: EK-TM4C123GXL
 // Target uC:       TM4C123GH6PM
-// System Clock:    -
+// System Clock:    80, 40 or 16 MHz
 
 // Hardware configuration:
 // 16 MHz external crystal oscillator
@@ -28,9 +28,25 @@
 // Subroutines
 //-----------------------------------------------------------------------------
 
-// Initialize system clock to 40 MHz using PLL and 16 MHz crystal oscillator
-void initSystemClockTo40Mhz(void)
+// Initialize system clock to SYSTEM_CLOCK_HZ from the 16 MHz crystal oscillator
+void initSystemClock(void)
 {
+#if SYSTEM_CLOCK_HZ == 80000000
+    // 80 MHz needs RCC2 for the 400 MHz PLL output and SYSDIV2LSB
+    // Run from the crystal while the PLL locks
+    SYSCTL_RCC2_R |= SYSCTL_RCC2_USERCC2 | SYSCTL_RCC2_BYPASS2;
+    SYSCTL_RCC_R = SYSCTL_RCC_XTAL_16MHZ | SYSCTL_RCC_OSCSRC_MAIN | SYSCTL_RCC_USESYSDIV | SYSCTL_RCC_BYPASS
+                 | SYSCTL_RCC_USEPWMDIV | SYSCTL_RCC_PWMDIV_2;
+    // 400 MHz / (2*2+0+1) = 80 MHz
+    SYSCTL_RCC2_R = SYSCTL_RCC2_USERCC2 | SYSCTL_RCC2_DIV400 | (2 << SYSCTL_RCC2_SYSDIV2_S) | SYSCTL_RCC2_BYPASS2
+                  | SYSCTL_RCC2_OSCSRC2_MO | SYSCTL_RCC2_USBPWRDN;
+    while (!(SYSCTL_PLLSTAT_R & SYSCTL_PLLSTAT_LOCK));
+    SYSCTL_RCC2_R &= ~SYSCTL_RCC2_BYPASS2;
+#elif SYSTEM_CLOCK_HZ == 40000000
     // Configure HW to work with 16 MHz XTAL, PLL enabled, sysdivider of 5, creating system clock of 40 MHz
     SYSCTL_RCC_R = SYSCTL_RCC_XTAL_16MHZ | SYSCTL_RCC_OSCSRC_MAIN | SYSCTL_RCC_USESYSDIV | (4 << SYSCTL_RCC_SYSDIV_S);
+#else
+    // Crystal straight through, PLL powered down
+    SYSCTL_RCC_R = SYSCTL_RCC_XTAL_16MHZ | SYSCTL_RCC_OSCSRC_MAIN | SYSCTL_RCC_BYPASS | SYSCTL_RCC_PWRDN;
+#endif
 }
@@ -7,7 +7,7 @@
 
 // Target Platform: EK-TM4C123GXL
 // Target uC:       TM4C123GH6PM
-// System Clock:    -
+// System Clock:    80, 40 or 16 MHz
 
 // Hardware configuration:
 // 16 MHz external crystal oscillator
@@ -19,10 +19,32 @@
 #ifndef CLOCK_H_
 #define CLOCK_H_
 
+#include <stdint.h>
+
+// System clock, everything that counts cycles is derived from this value
+// 80 MHz (PLL), 40 MHz (PLL) or 16 MHz (crystal, PLL off for low power)
+// Override with --define=SYSTEM_CLOCK_HZ=16000000 in the project settings
+#ifndef SYSTEM_CLOCK_HZ
+#define SYSTEM_CLOCK_HZ     80000000
+#endif
+#define SYSTEM_CLOCK_MHZ    (SYSTEM_CLOCK_HZ / 1000000)
+
+#if (SYSTEM_CLOCK_HZ != 80000000) && (SYSTEM_CLOCK_HZ != 40000000) && (SYSTEM_CLOCK_HZ != 16000000)
+#error "SYSTEM_CLOCK_HZ must be 80, 40 or 16 MHz"
+#endif
+
+// The PWM module runs at 40 MHz or less so the 1024 count motor period,
+// and with it every duty cycle in the program, stays the same
+#if SYSTEM_CLOCK_HZ == 80000000
+#define PWM_CLOCK_HZ        (SYSTEM_CLOCK_HZ / 2)
+#else
+#define PWM_CLOCK_HZ        SYSTEM_CLOCK_HZ
+#endif
+
 //-----------------------------------------------------------------------------
 // Subroutines
 //-----------------------------------------------------------------------------
 
-void initSystemClockTo40Mhz(void);
+void initSystemClock(void);
 
 #endif
@@ -0,0 +1,22 @@
+// Command Hash
+// Generated by tools/command_hash.py, do not edit
+
+// 27 commands in 64 slots: angle clear tilt forward reverse rotate pose slip controller timing top mem latency park power events uart baud ok scope config save load factory script telemetry help
+
+#ifndef COMMANDHASH_H_
+#define COMMANDHASH_H_
+
+#define COMMAND_HASH_SEED  0x811CA07A
+#define COMMAND_HASH_BITS  6
+#define COMMAND_HASH_COUNT 27
+
+// commandTable index + 1 by slot, 0 if free
+#define COMMAND_HASH_SLOTS \
+{ \
+     0,  0,  8, 16,  0,  0, 11,  0,  9,  0,  0,  0,  0,  0,  2,  0, \
+     0,  1, 24, 19,  0,  0, 26,  0,  0, 21,  0, 22,  0,  0,  5, 15, \
+     0,  0,  0,  0, 10, 25, 20,  4,  0,  0,  0,  0,  3,  0,  0,  0, \
+    13,  0,  0,  0, 23,  0,  0, 27, 14,  0, 17, 12,  0,  6, 18,  7 \
+}
+
+#endif
@@ -0,0 +1,201 @@
+// Command Library
+// Xavier
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    80 MHz
+
+// Hardware configuration: -
+
+// Every CLI command is one row of the command table in Project.c: its name,
+// how many arguments it takes and of what type, the handler, and the usage
+// and help lines that `help` prints. A line is checked against the row
+// before the handler runs, so handlers only see argument counts and types
+// they accept.
+// The name is looked up with a perfect hash: FNV-1a from a seed picked by
+// tools/command_hash.py so every name in the table lands in its own slot of
+// commandHash.h. One hash, one slot and one compare, however many commands
+// there are. The script has to be rerun when the table changes, initCommands()
+// checks that it was and falls back to a linear search if it wasn't.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "commands.h"
+#include "commandHash.h"
+#include "uart0.h"
+
+#define FNV_PRIME 16777619
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+const uint8_t commandSlots[1 << COMMAND_HASH_BITS] = COMMAND_HASH_SLOTS;
+
+const COMMAND* commandRows = 0;
+uint8_t commandCount = 0;
+bool commandHashValid = false;
+const COMMAND* currentCommand = 0;      // the command running, for printCommandUsage()
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// FNV-1a from the generated seed, must match tools/command_hash.py
+uint32_t hashCommand(const char* name)
+{
+    uint32_t hash = COMMAND_HASH_SEED;
+
+    while (*name != '\0')
+    {
+        hash ^= (uint8_t)*name++;
+        hash *= FNV_PRIME;
+    }
+    return hash >> (32 - COMMAND_HASH_BITS);
+}
+
+// Returns false if commandHash.h doesn't match the table, lookups are linear then
+bool initCommands(const COMMAND* table, uint8_t count)
+{
+    uint8_t i;
+
+    commandRows = table;
+    commandCount = count;
+    commandHashValid = (count == COMMAND_HASH_COUNT);
+    for (i = 0; i < count && commandHashValid; i++)
+        commandHashValid = (commandSlots[hashCommand(table[i].name)] == i + 1);
+
+    if (!commandHashValid)
+        printfUart0("commandHash.h is out of date, run tools/command_hash.py\n");
+    return commandHashValid;
+}
+
+const COMMAND* findCommand(const char* name)
+{
+    uint8_t slot;
+    uint8_t i;
+
+    if (commandHashValid)
+    {
+        slot = commandSlots[hashCommand(name)];
+        if (slot != 0 && customStrcmp(commandRows[slot - 1].name, name))
+            return &commandRows[slot - 1];
+        return 0;
+    }
+
+    for (i = 0; i < commandCount; i++)
+    {
+        if (customStrcmp(commandRows[i].name, name))
+            return &commandRows[i];
+    }
+    return 0;
+}
+
+bool isArgType(USER_DATA* data, uint8_t field, char type)
+{
+    char fieldType = data->fieldType[field];
+    uint8_t unit = getFieldUnit(data, field);
+
+    switch (type)
+    {
+        case ARG_WORD:
+            return fieldType == 'a';
+        case ARG_INTEGER:
+            return fieldType == 'n' && unit == UNIT_NONE;
+        case ARG_NUMBER:
+            return fieldType != 'a' && unit == UNIT_NONE;
+        case ARG_DISTANCE:
+            return fieldType != 'a' && (unit == UNIT_NONE || unit == UNIT_CM || unit == UNIT_M);
+        case ARG_ANGLE:
+            return fieldType != 'a' && (unit == UNIT_NONE || unit == UNIT_DEG);
+        default:
+            return true;
+    }
+}
+
+const char* getArgTypeName(char type)
+{
+    switch (type)
+    {
+        case ARG_WORD:     return "a word";
+        case ARG_INTEGER:  return "an integer";
+        case ARG_NUMBER:   return "a number";
+        case ARG_DISTANCE: return "a distance (m or cm)";
+        case ARG_ANGLE:    return "an angle (deg)";
+        default:           return "anything";
+    }
+}
+
+void printCommandUsage(void)
+{
+    if (currentCommand != 0)
+        printfUart0("usage: %s\n", currentCommand->usage);
+}
+
+// Looks up the first field, checks the arguments and runs the handler
+// Returns false, after saying why, if the line isn't a valid command
+bool dispatchCommand(USER_DATA* data)
+{
+    const COMMAND* command;
+    uint8_t args;
+    uint8_t i;
+
+    if (data->fieldCount == 0)
+        return false;
+
+    command = findCommand(getFieldString(data, 0));
+    if (command == 0)
+    {
+        printfUart0("unknown command %s, try help\n", getFieldString(data, 0));
+        return false;
+    }
+
+    currentCommand = command;
+    args = data->fieldCount - 1;
+    if (args < command->minArgs || args > command->maxArgs)
+    {
+        printCommandUsage();
+        return false;
+    }
+    for (i = 0; i < args && command->args[i] != '\0'; i++)
+    {
+        if (!isArgType(data, i + 1, command->args[i]))
+        {
+            printfUart0("%s: argument %u should be %s\n", command->name, i + 1, getArgTypeName(command->args[i]));
+            printCommandUsage();
+            return false;
+        }
+    }
+
+    command->handler(data);
+    currentCommand = 0;
+    return true;
+}
+
+// help, help <command>
+void helpCommand(USER_DATA* data)
+{
+    const COMMAND* command;
+    uint8_t i;
+
+    if (data->fieldCount > 1)
+    {
+        command = findCommand(getFieldString(data, 1));
+        if (command == 0)
+            printfUart0("unknown command %s\n", getFieldString(data, 1));
+        else
+            printfUart0("%s\n  %s\n", command->usage, command->help);
+        return;
+    }
+
+    for (i = 0; i < commandCount; i++)
+        printfUart0("  %-36s %s\n", commandRows[i].usage, commandRows[i].help);
+}
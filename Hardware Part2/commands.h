@@ -0,0 +1,58 @@
+// Command Library
+// Xavier
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    80 MHz
+
+// Hardware configuration: -
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef COMMANDS_H_
+#define COMMANDS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "uart0.h"
+
+// General Defines
+#define COMMAND_MAX_ARGS    (MAX_FIELDS - 1)
+
+// Argument types, one character per argument in COMMAND.args
+#define ARG_WORD            'w'     // starts with a letter
+#define ARG_INTEGER         'i'
+#define ARG_NUMBER          'n'     // integer or decimal
+#define ARG_DISTANCE        'd'     // number, m if it has no unit, or cm
+#define ARG_ANGLE           'a'     // number, deg
+#define ARG_ANY             '?'
+
+// Structs
+typedef struct _COMMAND
+{
+    const char* name;
+    uint8_t minArgs;
+    uint8_t maxArgs;
+    const char* args;               // types of the arguments, ARG_ characters
+    void (*handler)(USER_DATA* data);
+    const char* usage;
+    const char* help;
+} COMMAND;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+uint32_t hashCommand(const char* name);
+bool initCommands(const COMMAND* table, uint8_t count);
+bool dispatchCommand(USER_DATA* data);
+void printCommandUsage(void);
+void helpCommand(USER_DATA* data);
+
+#endif
@@ -0,0 +1,220 @@
+// Config Library
+// Xavier
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    80 MHz
+
+// Hardware configuration:
+// On-chip EEPROM
+
+// Tuning and calibration kept over resets. The EEPROM holds two copies of
+// the record, A and B, and a save always writes the one not in use, so a
+// reset in the middle of a save leaves the last good copy untouched. A
+// copy is
+//   magic (1), version << 16 | length (1), sequence (1), CONFIG (length),
+//   CRC-32 (1) over all the words before it
+// Loading takes the copy with the newest sequence that passes its CRC. A
+// copy from an older version keeps the fields it had and the fields added
+// since start at their defaults. Anything else, blank, corrupt or written
+// by newer firmware, loads the defaults, which stay in RAM until `save`.
+// eeprom.c doesn't program words that already hold the value, and the copy
+// being written is the one from two saves ago, so a save mostly costs the
+// header, the CRC and the fields that changed.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "config.h"
+#include "eeprom.h"
+#include "uart0.h"
+
+#define CONFIG_MAGIC        0x47464E43  // "CNFG"
+#define CONFIG_HEADER_WORDS 3
+#define CONFIG_WORDS        (sizeof(CONFIG) / 4)
+#define CONFIG_MAX_WORDS    (CONFIG_SLOT_WORDS - CONFIG_HEADER_WORDS - 1)
+#define CONFIG_BLANK        0xFFFFFFFF  // erased EEPROM word
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+const CONFIG* configDefaults = 0;
+CONFIG configSaved;                 // what the copy in use holds ...
+bool configSavedValid = false;      // ... if it is what was loaded or saved
+uint32_t configRecord[CONFIG_SLOT_WORDS];
+CONFIG_STATUS configStatus = { CONFIG_NO_EEPROM, -1, 0, 0 };
+
+// CRC-32 (poly 0xEDB88320, reflected) a nibble at a time
+const uint32_t crc32Table[16] =
+{
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+uint32_t crc32Words(const uint32_t* data, uint16_t count)
+{
+    uint32_t crc = 0xFFFFFFFF;
+    uint8_t i;
+
+    while (count--)
+    {
+        crc ^= *data++;
+        for (i = 0; i < 8; i++)
+            crc = (crc >> 4) ^ crc32Table[crc & 0x0F];
+    }
+    return ~crc;
+}
+
+uint16_t getSlotAddress(uint8_t slot)
+{
+    return slot * CONFIG_SLOT_WORDS;
+}
+
+void initConfig(const CONFIG* defaults)
+{
+    configDefaults = defaults;
+    configStatus.lastResult = CONFIG_NO_EEPROM;
+    configStatus.slot = -1;
+    configStatus.sequence = 0;
+    configStatus.corruptSlots = 0;
+}
+
+// Reads a copy into configRecord, false if it is blank or fails the check
+bool readSlot(uint8_t slot, bool* corrupt)
+{
+    uint16_t length;
+
+    *corrupt = false;
+    if (!readEeprom(getSlotAddress(slot), configRecord, CONFIG_HEADER_WORDS))
+        return false;
+    if (configRecord[0] != CONFIG_MAGIC)
+    {
+        *corrupt = (configRecord[0] != CONFIG_BLANK);
+        return false;
+    }
+    length = configRecord[1] & 0xFFFF;
+    *corrupt = true;
+    if (length > CONFIG_MAX_WORDS)
+        return false;
+    if (!readEeprom(getSlotAddress(slot) + CONFIG_HEADER_WORDS, configRecord + CONFIG_HEADER_WORDS, length + 1))
+        return false;
+    if (crc32Words(configRecord, CONFIG_HEADER_WORDS + length) != configRecord[CONFIG_HEADER_WORDS + length])
+        return false;
+    *corrupt = false;
+    return true;
+}
+
+// Fills config from the newest good copy, or with the defaults if there is none
+ConfigResult loadConfig(CONFIG* config)
+{
+    uint32_t sequence[CONFIG_SLOTS];
+    bool valid[CONFIG_SLOTS], corrupt;
+    int8_t newest = -1;
+    uint16_t version, length;
+    uint8_t slot;
+
+    *config = *configDefaults;
+    configStatus.slot = -1;
+    configStatus.corruptSlots = 0;
+    configSavedValid = false;
+    if (getEepromWords() < CONFIG_SLOTS * CONFIG_SLOT_WORDS)
+        return configStatus.lastResult = CONFIG_NO_EEPROM;
+
+    for (slot = 0; slot < CONFIG_SLOTS; slot++)
+    {
+        valid[slot] = readSlot(slot, &corrupt);
+        sequence[slot] = configRecord[2];
+        if (corrupt)
+            configStatus.corruptSlots++;
+        // Sequence numbers compared as a difference, a wrap doesn't matter
+        if (valid[slot] && (newest < 0 || (int32_t)(sequence[slot] - sequence[newest]) > 0))
+            newest = slot;
+    }
+    if (newest < 0)
+        return configStatus.lastResult = configStatus.corruptSlots ? CONFIG_DEFAULTS_CORRUPT : CONFIG_DEFAULTS_BLANK;
+
+    readSlot(newest, &corrupt);
+    version = configRecord[1] >> 16;
+    length = configRecord[1] & 0xFFFF;
+    configStatus.slot = newest;
+    configStatus.sequence = sequence[newest];
+    if (version > CONFIG_VERSION || (version == CONFIG_VERSION && length != CONFIG_WORDS) || length > CONFIG_WORDS)
+        return configStatus.lastResult = CONFIG_DEFAULTS_VERSION;
+
+    memcpy(config, configRecord + CONFIG_HEADER_WORDS, length * 4);
+    if (version < CONFIG_VERSION)
+        return configStatus.lastResult = CONFIG_MIGRATED;
+    configSaved = *config;
+    configSavedValid = true;
+    return configStatus.lastResult = CONFIG_LOADED;
+}
+
+// Writes the copy not in use and switches to it once it reads back good
+ConfigResult saveConfig(const CONFIG* config)
+{
+    uint8_t slot;
+    bool corrupt;
+
+    if (getEepromWords() < CONFIG_SLOTS * CONFIG_SLOT_WORDS)
+        return configStatus.lastResult = CONFIG_NO_EEPROM;
+    if (configSavedValid && memcmp(config, &configSaved, sizeof(CONFIG)) == 0)
+        return configStatus.lastResult = CONFIG_UNCHANGED;
+
+    slot = (configStatus.slot == 0) ? 1 : 0;
+    configRecord[0] = CONFIG_MAGIC;
+    configRecord[1] = ((uint32_t)CONFIG_VERSION << 16) | CONFIG_WORDS;
+    configRecord[2] = configStatus.sequence + 1;
+    memcpy(configRecord + CONFIG_HEADER_WORDS, config, sizeof(CONFIG));
+    configRecord[CONFIG_HEADER_WORDS + CONFIG_WORDS] = crc32Words(configRecord, CONFIG_HEADER_WORDS + CONFIG_WORDS);
+
+    if (!writeEeprom(getSlotAddress(slot), configRecord, CONFIG_HEADER_WORDS + CONFIG_WORDS + 1)
+        || !readSlot(slot, &corrupt) || memcmp(configRecord + CONFIG_HEADER_WORDS, config, sizeof(CONFIG)) != 0)
+        return configStatus.lastResult = CONFIG_WRITE_FAILED;
+
+    configSaved = *config;
+    configSavedValid = true;
+    configStatus.slot = slot;
+    configStatus.sequence++;
+    return configStatus.lastResult = CONFIG_SAVED;
+}
+
+CONFIG_STATUS getConfigStatus(void)
+{
+    return configStatus;
+}
+
+const char* getConfigResultName(ConfigResult result)
+{
+    const char* resultNames[] = { "loaded", "migrated from an older version", "defaults, nothing saved",
+                                  "defaults, saved copies are corrupt", "defaults, saved by newer firmware",
+                                  "defaults, no EEPROM", "saved", "unchanged, nothing written", "write failed" };
+
+    return resultNames[result];
+}
+
+void printConfigStatus(void)
+{
+    EEPROM_STATS stats = getEepromStats();
+
+    printfUart0("config %s\n", getConfigResultName(configStatus.lastResult));
+    if (configStatus.slot < 0)
+        printfUart0("  no copy in use");
+    else
+        printfUart0("  copy %c, save %u", 'A' + configStatus.slot, configStatus.sequence);
+    if (configStatus.corruptSlots)
+        printfUart0(", %u corrupt", configStatus.corruptSlots);
+    printfUart0("\n  EEPROM %u words written, %u unchanged, %u errors\n", stats.wordsWritten, stats.wordsSkipped, stats.errors);
+}
@@ -0,0 +1,75 @@
+// Config Library
+// Xavier
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    80 MHz
+
+// Hardware configuration:
+// On-chip EEPROM
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef CONFIG_H_
+#define CONFIG_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// General Defines
+#define CONFIG_VERSION      1       // bump when CONFIG changes, add fields only at the end
+#define CONFIG_IR_KEYS      19
+#define CONFIG_SLOT_WORDS   64      // per copy, room for the record to grow
+#define CONFIG_SLOTS        2
+
+// Structs
+// Words only, the record is stored as it is in RAM
+typedef struct _CONFIG
+{
+    float balanceGains[3];          // kp ki kd of balancePID
+    float straightGains[3];         // kp ki kd of straightPID
+    uint32_t minSpeed;              // PWM the motors start turning at
+    uint32_t irCodes[CONFIG_IR_KEYS];
+    float gyroBias[3];              // deg/s, subtracted from the gyro
+    float accelTrim[3];             // g, subtracted from the accelerometer
+} CONFIG;
+
+typedef enum
+{
+    CONFIG_LOADED,
+    CONFIG_MIGRATED,                // older version, the fields it didn't have are defaults
+    CONFIG_DEFAULTS_BLANK,          // nothing saved yet
+    CONFIG_DEFAULTS_CORRUPT,        // no copy passed the CRC
+    CONFIG_DEFAULTS_VERSION,        // saved by newer firmware
+    CONFIG_NO_EEPROM,
+    CONFIG_SAVED,
+    CONFIG_UNCHANGED,               // same as the saved copy, nothing written
+    CONFIG_WRITE_FAILED
+} ConfigResult;
+
+typedef struct _CONFIG_STATUS
+{
+    ConfigResult lastResult;
+    int8_t slot;                    // copy in use, -1 if none
+    uint32_t sequence;              // saves so far
+    uint8_t corruptSlots;           // copies that failed the CRC on the last load
+} CONFIG_STATUS;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initConfig(const CONFIG* defaults);
+ConfigResult loadConfig(CONFIG* config);
+ConfigResult saveConfig(const CONFIG* config);
+CONFIG_STATUS getConfigStatus(void);
+const char* getConfigResultName(ConfigResult result);
+void printConfigStatus(void);
+
+#endif
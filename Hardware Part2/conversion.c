@@ -8,8 +8,8 @@
 #include <stdbool.h>
 
 #include <inttypes.h>
-#include <stdio.h>
 #include <string.h>
+#include "format.h"
 
 #define CHAR_BUFF_SIZE 80
 char retVal[80];
@@ -137,10 +137,10 @@ char* int_to_str(int num)
     }
 }
 
-// NOTE Only use if stack is high enough.
+// Shares retVal with the others, not for ISRs
 char* float_to_str(float* x)
 {
-    sprintf(retVal, "%f", *x);
+    formatString(retVal, sizeof(retVal), "%f", *x);
     return retVal;
 }
 
@@ -8,7 +8,6 @@
 #include <stdbool.h>
 
 #include <inttypes.h>
-#include <stdio.h>
 #include <string.h>
 
 #define CHAR_BUFF_SIZE 80
@@ -33,7 +32,7 @@ char* uint_to_str(uint32_t num);
 
 char* int_to_str(int num);
 
-// NOTE Only use if stack is high enough.
+// Shares retVal with the others, not for ISRs
 char* float_to_str(float* x);
 
 
@@ -0,0 +1,270 @@
+// Crash Report Library
+// Xavier
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    80 MHz
+
+// Hardware configuration: -
+
+// NMI (the watchdog), hard, memory, bus and usage faults all enter faultIsr.
+// It hands the exception frame to faultHandler(), which copies the stacked
+// registers, the fault status registers, the running task and a trace of the
+// last few events into RAM the C startup doesn't clear. It then cuts the
+// motors and resets. The next boot decodes the record over UART. Give
+// the pc and lr lines to tools/symbolize_crash.py with the build's .map file
+// to get function names.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "tm4c123gh6pm.h"
+#include "crash.h"
+#include "motorControl.h"
+#include "scheduler.h"
+#include "watchdog.h"
+#include "timing.h"
+#include "uart0.h"
+
+#define CRASH_MAGIC     0x43525348      // "CRSH", a report is waiting
+#define CRASH_REPORTED  0x4F4B4159      // "OKAY", count and trace are valid
+
+// CFSR bits
+#define CFSR_IACCVIOL   0x00000001
+#define CFSR_DACCVIOL   0x00000002
+#define CFSR_MUNSTKERR  0x00000008
+#define CFSR_MSTKERR    0x00000010
+#define CFSR_MLSPERR    0x00000020
+#define CFSR_MMARVALID  0x00000080
+#define CFSR_IBUSERR    0x00000100
+#define CFSR_PRECISERR  0x00000200
+#define CFSR_IMPRECISERR 0x00000400
+#define CFSR_UNSTKERR   0x00000800
+#define CFSR_STKERR     0x00001000
+#define CFSR_LSPERR     0x00002000
+#define CFSR_BFARVALID  0x00008000
+#define CFSR_UNDEFINSTR 0x00010000
+#define CFSR_INVSTATE   0x00020000
+#define CFSR_INVPC      0x00040000
+#define CFSR_NOCP       0x00080000
+#define CFSR_UNALIGNED  0x01000000
+#define CFSR_DIVBYZERO  0x02000000
+
+// HFSR bits
+#define HFSR_VECTTBL    0x00000002
+#define HFSR_FORCED     0x40000000
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+typedef struct _CRASH_RECORD
+{
+    uint32_t magic;             // CRASH_MAGIC when the rest is a crash to report
+    uint32_t count;             // crashes since power-on
+    uint32_t exception;         // 2 NMI (watchdog), 3 hard, 4 memory, 5 bus, 6 usage
+    uint32_t r0, r1, r2, r3, r12, lr, pc, xpsr;
+    uint32_t sp;                // stack pointer before the exception
+    uint32_t excReturn;
+    uint32_t cfsr, hfsr, mmfar, bfar;
+    uint32_t time;              // CYCCNT at the fault
+    uint8_t task;               // scheduler task running, SCHEDULER_NONE if none
+    uint8_t missing;            // watchdog check-ins absent at an NMI
+    uint8_t traceHead;          // next trace slot
+    TRACE_EVENT trace[CRASH_TRACE_LENGTH];
+} CRASH_RECORD;
+
+#pragma NOINIT(crashRecord)
+CRASH_RECORD crashRecord;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// Separate memory, bus and usage faults instead of escalating everything to
+// a hard fault, and trap divide by zero
+void initCrash(void)
+{
+    NVIC_SYS_HND_CTRL_R |= NVIC_SYS_HND_CTRL_USAGE | NVIC_SYS_HND_CTRL_BUS | NVIC_SYS_HND_CTRL_MEM;
+    NVIC_CFG_CTRL_R |= NVIC_CFG_CTRL_DIV0;
+}
+
+// A few stores, cheap enough for every task run
+void traceEvent(uint8_t event, uint32_t data)
+{
+    uint8_t head = crashRecord.traceHead % CRASH_TRACE_LENGTH;
+    crashRecord.trace[head].time = DWT_CYCCNT_R;
+    crashRecord.trace[head].data = data;
+    crashRecord.trace[head].event = event;
+    crashRecord.traceHead = head + 1;
+}
+
+// Packs up to the first 4 characters, enough to tell commands apart
+void traceText(uint8_t event, const char* text)
+{
+    uint32_t packed = 0;
+    uint8_t i;
+
+    for (i = 0; (i < 4) && (text[i] != '\0'); i++)
+        packed |= (uint32_t)(uint8_t)text[i] << (i * 8);
+    traceEvent(event, packed);
+}
+
+// Finds the frame on whichever stack was in use and passes EXC_RETURN and IPSR along
+// Nothing here touches the stack, so the frame is exactly where the core left it
+void faultIsr(void)
+{
+    __asm(" TST   LR, #4\n"
+          " ITE   EQ\n"
+          " MRSEQ R0, MSP\n"
+          " MRSNE R0, PSP\n"
+          " MOV   R1, LR\n"
+          " MRS   R2, IPSR\n"
+          " B     faultHandler");
+}
+
+void faultHandler(uint32_t* frame, uint32_t excReturn, uint32_t ipsr)
+{
+    // Motors first, the record can wait a few cycles
+    safeMotors();
+
+    if ((crashRecord.magic != CRASH_MAGIC) && (crashRecord.magic != CRASH_REPORTED))
+        crashRecord.count = 0;
+    crashRecord.count++;
+    crashRecord.exception = ipsr & 0x1FF;
+    crashRecord.r0 = frame[0];
+    crashRecord.r1 = frame[1];
+    crashRecord.r2 = frame[2];
+    crashRecord.r3 = frame[3];
+    crashRecord.r12 = frame[4];
+    crashRecord.lr = frame[5];
+    crashRecord.pc = frame[6];
+    crashRecord.xpsr = frame[7];
+    crashRecord.sp = (uint32_t)frame + ((excReturn & 0x10) ? 32 : 104) + ((frame[7] & 0x200) ? 4 : 0);
+    crashRecord.excReturn = excReturn;
+    crashRecord.cfsr = NVIC_FAULT_STAT_R;
+    crashRecord.hfsr = NVIC_HFAULT_STAT_R;
+    crashRecord.mmfar = NVIC_MM_ADDR_R;
+    crashRecord.bfar = NVIC_FAULT_ADDR_R;
+    crashRecord.time = DWT_CYCCNT_R;
+    crashRecord.task = getActiveTask();
+    crashRecord.missing = getMissingCheckins();
+    crashRecord.magic = CRASH_MAGIC;
+
+    NVIC_APINT_R = NVIC_APINT_VECTKEY | NVIC_APINT_SYSRESETREQ;
+    while (true);
+}
+
+void printCfsr(uint32_t cfsr)
+{
+    if (cfsr & CFSR_IACCVIOL)    printfUart0(" IACCVIOL");
+    if (cfsr & CFSR_DACCVIOL)    printfUart0(" DACCVIOL");
+    if (cfsr & CFSR_MUNSTKERR)   printfUart0(" MUNSTKERR");
+    if (cfsr & CFSR_MSTKERR)     printfUart0(" MSTKERR");
+    if (cfsr & CFSR_MLSPERR)     printfUart0(" MLSPERR");
+    if (cfsr & CFSR_IBUSERR)     printfUart0(" IBUSERR");
+    if (cfsr & CFSR_PRECISERR)   printfUart0(" PRECISERR");
+    if (cfsr & CFSR_IMPRECISERR) printfUart0(" IMPRECISERR");
+    if (cfsr & CFSR_UNSTKERR)    printfUart0(" UNSTKERR");
+    if (cfsr & CFSR_STKERR)      printfUart0(" STKERR");
+    if (cfsr & CFSR_LSPERR)      printfUart0(" LSPERR");
+    if (cfsr & CFSR_UNDEFINSTR)  printfUart0(" UNDEFINSTR");
+    if (cfsr & CFSR_INVSTATE)    printfUart0(" INVSTATE");
+    if (cfsr & CFSR_INVPC)       printfUart0(" INVPC");
+    if (cfsr & CFSR_NOCP)        printfUart0(" NOCP");
+    if (cfsr & CFSR_UNALIGNED)   printfUart0(" UNALIGNED");
+    if (cfsr & CFSR_DIVBYZERO)   printfUart0(" DIVBYZERO");
+}
+
+void clearTrace(uint32_t resetCause)
+{
+    uint8_t i;
+
+    crashRecord.traceHead = 0;
+    for (i = 0; i < CRASH_TRACE_LENGTH; i++)
+        crashRecord.trace[i].event = 0;
+    traceEvent(TRACE_BOOT, resetCause);
+}
+
+// Called once at boot after UART0 is up and the task table is known
+// with the cause reportResetCause() read
+void reportCrash(uint32_t resetCause)
+{
+    CRASH_RECORD* c = &crashRecord;
+    TRACE_EVENT* e;
+    char text[5];
+    uint8_t i, j;
+
+    // RAM is garbage after power-on, start the record over
+    if ((resetCause & (SYSCTL_RESC_POR | SYSCTL_RESC_BOR)) || ((c->magic != CRASH_MAGIC) && (c->magic != CRASH_REPORTED)))
+    {
+        c->magic = CRASH_REPORTED;
+        c->count = 0;
+    }
+    if (c->magic != CRASH_MAGIC)
+    {
+        clearTrace(resetCause);
+        return;
+    }
+
+    printfUart0("\n*** Crash %u since power-on: ", c->count);
+    switch (c->exception)
+    {
+        case 2:  printfUart0("watchdog expired, missing check-ins 0x%x\n", c->missing); break;
+        case 3:  printfUart0("hard fault\n"); break;
+        case 4:  printfUart0("memory management fault\n"); break;
+        case 5:  printfUart0("bus fault\n"); break;
+        case 6:  printfUart0("usage fault\n"); break;
+        default: printfUart0("exception %u\n", c->exception); break;
+    }
+    if (c->task != SCHEDULER_NONE)
+        printfUart0("task %s\n", getTaskName(c->task));
+    else
+        printfUart0("task none (main or an ISR, exception %u when it hit)\n", c->xpsr & 0x1FF);
+
+    printfUart0("pc 0x%x\nlr 0x%x\n", c->pc, c->lr);
+    printfUart0("r0 0x%x  r1 0x%x  r2 0x%x  r3 0x%x  r12 0x%x\n", c->r0, c->r1, c->r2, c->r3, c->r12);
+    printfUart0("xpsr 0x%x  sp 0x%x  exc_return 0x%x\n", c->xpsr, c->sp, c->excReturn);
+    printfUart0("cfsr 0x%x", c->cfsr);
+    printCfsr(c->cfsr);
+    printfUart0("\nhfsr 0x%x%s%s\n", c->hfsr, (c->hfsr & HFSR_FORCED) ? " FORCED" : "", (c->hfsr & HFSR_VECTTBL) ? " VECTTBL" : "");
+    if (c->cfsr & CFSR_MMARVALID)
+        printfUart0("mmfar 0x%x\n", c->mmfar);
+    if (c->cfsr & CFSR_BFARVALID)
+        printfUart0("bfar 0x%x\n", c->bfar);
+
+    printfUart0("last events, us before the crash:\n");
+    for (i = 0; i < CRASH_TRACE_LENGTH; i++)
+    {
+        e = &c->trace[(c->traceHead + i) % CRASH_TRACE_LENGTH];
+        if (e->event == 0)
+            continue;
+        printfUart0("  -%u ", (c->time - e->time) / TIMING_CYCLES_PER_US);
+        switch (e->event)
+        {
+            case TRACE_BOOT: printfUart0("boot, resc 0x%x\n", e->data); break;
+            case TRACE_TASK: printfUart0("task %s\n", getTaskName(e->data)); break;
+            case TRACE_IR:   printfUart0("ir %u\n", e->data); break;
+            case TRACE_CLI:
+                for (j = 0; j < 4; j++)
+                    text[j] = (e->data >> (j * 8)) & 0xFF;
+                text[4] = '\0';
+                printfUart0("cli %s\n", text);
+                break;
+            case TRACE_PARK: printfUart0("park %u\n", e->data); break;
+            default:         printfUart0("event %u 0x%x\n", e->event, e->data); break;
+        }
+    }
+    printfUart0("***\n\n");
+
+    // Report once, keep the count, start a fresh trace
+    c->magic = CRASH_REPORTED;
+    clearTrace(resetCause);
+}
@@ -0,0 +1,53 @@
+// Crash Report Library
+// Xavier
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    80 MHz
+
+// Hardware configuration: -
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef CRASH_H_
+#define CRASH_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// General Defines
+#define CRASH_TRACE_LENGTH  16      // recent events kept for the report
+
+// Trace events
+#define TRACE_BOOT          1
+#define TRACE_TASK          2       // data = task
+#define TRACE_IR            3       // data = decoded code
+#define TRACE_CLI           4       // data = first 4 characters of the command
+#define TRACE_PARK          5       // data = 1 parked, 0 awake
+
+// Structs
+typedef struct _TRACE_EVENT
+{
+    uint32_t time;      // CYCCNT
+    uint32_t data;
+    uint8_t event;
+} TRACE_EVENT;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initCrash(void);
+void traceEvent(uint8_t event, uint32_t data);
+void traceText(uint8_t event, const char* text);
+void faultIsr(void);
+void faultHandler(uint32_t* frame, uint32_t excReturn, uint32_t ipsr);
+void reportCrash(uint32_t resetCause);
+
+#endif
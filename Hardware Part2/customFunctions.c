@@ -51,15 +51,15 @@ void readNprintMPU6050(void)
     float fgy = (gy/131.0);
     float fgz = (gz/131.0);
 
-    printfUart0("Read Data ax =    %f\n", &fax);
-    printfUart0("Read Data ay =    %f\n", &fay);
-    printfUart0("Read Data az =    %f\n\n", &faz);
+    printfUart0("Read Data ax =    %f\n", fax);
+    printfUart0("Read Data ay =    %f\n", fay);
+    printfUart0("Read Data az =    %f\n\n", faz);
 
-    printfUart0("Read Data gx =    %f\n", &fgx);
-    printfUart0("Read Data gy =    %f\n", &fgy);
-    printfUart0("Read Data gz =    %f\n\n", &fgz);
+    printfUart0("Read Data gx =    %f\n", fgx);
+    printfUart0("Read Data gy =    %f\n", fgy);
+    printfUart0("Read Data gz =    %f\n\n", fgz);
 
-    printfUart0("tilt Angle   =    %f\n\n", &tiltAngle);
+    printfUart0("tilt Angle   =    %f\n\n", tiltAngle);
 }
 
 // 250 deg/sec
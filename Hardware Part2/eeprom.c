@@ -0,0 +1,132 @@
+// EEPROM Library
+// Xavier
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    80 MHz
+
+// Hardware configuration:
+// On-chip EEPROM, 2 KB in 32 blocks of 16 words
+
+// Addresses are in words from the start of the EEPROM. A word is
+// programmed only if it holds a different value, rewriting a record that
+// barely changed costs the few words that did. The EEPROM wears per word
+// (500k writes), each write takes up to a few ms and stalls flash reads
+// while it runs, so this is for configuration and not for anything a
+// control loop touches.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "tm4c123gh6pm.h"
+#include "eeprom.h"
+
+#define EEPROM_DONE_ERRORS (EEPROM_EEDONE_WRBUSY | EEPROM_EEDONE_NOPERM)
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+bool eepromReady = false;
+uint16_t eepromWords = 0;
+EEPROM_STATS eepromStats;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void waitEeprom(void)
+{
+    while (EEPROM_EEDONE_R & EEPROM_EEDONE_WORKING);
+}
+
+// Start-up sequence of the data sheet (8.2.4.1), false if the EEPROM is unusable
+bool initEeprom(void)
+{
+    SYSCTL_RCGCEEPROM_R |= SYSCTL_RCGCEEPROM_R0;
+    _delay_cycles(6);
+    waitEeprom();
+
+    // A write cut short by a reset has to be finished before anything else
+    if (EEPROM_EESUPP_R & (EEPROM_EESUPP_PRETRY | EEPROM_EESUPP_ERETRY))
+        return false;
+
+    SYSCTL_SREEPROM_R |= SYSCTL_SREEPROM_R0;
+    _delay_cycles(6);
+    SYSCTL_SREEPROM_R &= ~SYSCTL_SREEPROM_R0;
+    _delay_cycles(6);
+    waitEeprom();
+    if (EEPROM_EESUPP_R & (EEPROM_EESUPP_PRETRY | EEPROM_EESUPP_ERETRY))
+        return false;
+
+    eepromWords = (EEPROM_EESIZE_R & EEPROM_EESIZE_WORDCNT_M) >> EEPROM_EESIZE_WORDCNT_S;
+    eepromStats.wordsWritten = 0;
+    eepromStats.wordsSkipped = 0;
+    eepromStats.errors = 0;
+    eepromReady = true;
+    return true;
+}
+
+uint16_t getEepromWords(void)
+{
+    return eepromWords;
+}
+
+void selectEepromWord(uint16_t address)
+{
+    EEPROM_EEBLOCK_R = address / EEPROM_BLOCK_WORDS;
+    EEPROM_EEOFFSET_R = address % EEPROM_BLOCK_WORDS;
+}
+
+bool readEeprom(uint16_t address, uint32_t* data, uint16_t count)
+{
+    uint16_t i;
+
+    if (!eepromReady || (uint32_t)address + count > eepromWords)
+        return false;
+    for (i = 0; i < count; i++)
+    {
+        selectEepromWord(address + i);
+        data[i] = EEPROM_EERDWR_R;
+    }
+    return true;
+}
+
+// Returns false on the first word that fails to program
+bool writeEeprom(uint16_t address, const uint32_t* data, uint16_t count)
+{
+    uint16_t i;
+
+    if (!eepromReady || (uint32_t)address + count > eepromWords)
+        return false;
+    for (i = 0; i < count; i++)
+    {
+        selectEepromWord(address + i);
+        if (EEPROM_EERDWR_R == data[i])
+        {
+            eepromStats.wordsSkipped++;
+            continue;
+        }
+        EEPROM_EERDWR_R = data[i];
+        waitEeprom();
+        if ((EEPROM_EEDONE_R & EEPROM_DONE_ERRORS) || (EEPROM_EERDWR_R != data[i]))
+        {
+            eepromStats.errors++;
+            return false;
+        }
+        eepromStats.wordsWritten++;
+    }
+    return true;
+}
+
+EEPROM_STATS getEepromStats(void)
+{
+    return eepromStats;
+}
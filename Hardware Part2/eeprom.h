@@ -0,0 +1,46 @@
+// EEPROM Library
+// Xavier
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    80 MHz
+
+// Hardware configuration:
+// On-chip EEPROM, 2 KB in 32 blocks of 16 words
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef EEPROM_H_
+#define EEPROM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// General Defines
+#define EEPROM_BLOCK_WORDS  16
+
+// Structs
+typedef struct _EEPROM_STATS
+{
+    uint32_t wordsWritten;
+    uint32_t wordsSkipped;  // already held the value, not written
+    uint32_t errors;
+} EEPROM_STATS;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+bool initEeprom(void);
+uint16_t getEepromWords(void);
+bool readEeprom(uint16_t address, uint32_t* data, uint16_t count);
+bool writeEeprom(uint16_t address, const uint32_t* data, uint16_t count);
+EEPROM_STATS getEepromStats(void);
+
+#endif
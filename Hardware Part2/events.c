@@ -0,0 +1,100 @@
+// Event Queue Library
+// Xavier
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    80 MHz
+
+// Hardware configuration: -
+
+// ISRs and scheduler tasks post typed events, the main loop takes them one at
+// a time and only runs a handler when something happened. Posters sit at
+// several interrupt priorities, so the slot is claimed with interrupts masked
+// for a few instructions. There is one consumer, the main loop, so taking an
+// event needs no masking. A full queue drops the new event and counts it.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "events.h"
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+EVENT eventQueue[EVENT_QUEUE_LENGTH];
+volatile uint8_t eventHead = 0;     // next slot to write, posters only
+volatile uint8_t eventTail = 0;     // next slot to read, main loop only
+
+EVENT_STATS eventStats;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initEvents(void)
+{
+    eventHead = 0;
+    eventTail = 0;
+    clearEventStats();
+}
+
+// Safe from any ISR or task, returns false if the queue was full
+bool postEvent(EventType type, uint32_t data)
+{
+    uint32_t primask = _disable_interrupts();   // compiler intrinsic, returns the old PRIMASK
+    uint8_t head = eventHead;
+    uint8_t depth = (uint8_t)(head - eventTail);
+
+    if (depth >= EVENT_QUEUE_LENGTH)
+    {
+        eventStats.dropped++;
+        _restore_interrupts(primask);
+        return false;
+    }
+    eventQueue[head % EVENT_QUEUE_LENGTH].type = type;
+    eventQueue[head % EVENT_QUEUE_LENGTH].data = data;
+    eventHead = head + 1;
+
+    eventStats.posted++;
+    if (depth + 1 > eventStats.maxDepth)
+        eventStats.maxDepth = depth + 1;
+    _restore_interrupts(primask);
+    return true;
+}
+
+// Main loop only, returns false if there was nothing to take
+bool getEvent(EVENT* event)
+{
+    uint8_t tail = eventTail;
+
+    if (tail == eventHead)
+        return false;
+    *event = eventQueue[tail % EVENT_QUEUE_LENGTH];
+    eventTail = tail + 1;
+    return true;
+}
+
+bool eventsPending(void)
+{
+    return eventTail != eventHead;
+}
+
+EVENT_STATS getEventStats(void)
+{
+    return eventStats;
+}
+
+void clearEventStats(void)
+{
+    eventStats.posted = 0;
+    eventStats.dropped = 0;
+    eventStats.maxDepth = 0;
+}
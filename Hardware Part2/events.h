@@ -0,0 +1,65 @@
+// Event Queue Library
+// Xavier
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    80 MHz
+
+// Hardware configuration: -
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef EVENTS_H_
+#define EVENTS_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// General Defines
+#define EVENT_QUEUE_LENGTH  16      // power of two
+
+// Structs
+typedef enum
+{
+    EVENT_NONE,
+    EVENT_IR_CODE,          // data = decoded NEC code
+    EVENT_IR_HELD,          // first repeat code of a held key
+    EVENT_IR_RELEASE,       // no repeat code for 200 ms
+    EVENT_UART_RX,          // characters waiting in UART0
+    EVENT_BUTTON,           // data = 1 or 2, the push button pressed
+    EVENT_MOTION_DONE,      // a timed move reached its deadline
+    EVENT_SCRIPT_END,       // data = ScriptState the script ended in
+    EVENT_SCOPE_DUMP        // a scope capture is waiting to be sent
+} EventType;
+
+typedef struct _EVENT
+{
+    EventType type;
+    uint32_t data;
+} EVENT;
+
+typedef struct _EVENT_STATS
+{
+    uint32_t posted;
+    uint32_t dropped;       // posted while the queue was full
+    uint8_t maxDepth;
+} EVENT_STATS;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initEvents(void);
+bool postEvent(EventType type, uint32_t data);
+bool getEvent(EVENT* event);
+bool eventsPending(void);
+EVENT_STATS getEventStats(void);
+void clearEventStats(void);
+
+#endif
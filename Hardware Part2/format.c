@@ -0,0 +1,469 @@
+// Format Library
+// Xavier
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    80 MHz
+
+// Hardware configuration: -
+
+// printf-style formatting without the C library. Characters go to a put
+// function one at a time, so nothing is allocated and nothing is shared:
+// an ISR can format while the main loop is in the middle of its own call.
+// Numbers are converted into a small buffer on the stack. Integers use 32-bit
+// division, 64-bit only for the part of a %ll value above 32 bits.
+// %f splits the value into integer and fraction parts and rounds the fraction
+// as an integer, half to even like printf, so it costs a handful of double
+// operations whatever the precision. Values of 2^64 and above print as "ovf".
+// %q prints a fixed-point value exactly, rounding half up on the last digit.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include "format.h"
+
+#define FORMAT_LEFT     0x01    // -
+#define FORMAT_ZERO     0x02    // 0
+#define FORMAT_PLUS     0x04    // +
+#define FORMAT_SPACE    0x08    // space
+#define FORMAT_ALT      0x10    // #, 0x on hex
+
+#define FORMAT_DIGITS   24      // 2^64 in decimal is 20 digits
+
+// Structs
+typedef struct _FORMAT_OUTPUT
+{
+    void (*put)(char c, void* context);
+    void* context;
+    uint32_t count;
+} FORMAT_OUTPUT;
+
+typedef struct _FORMAT_SPEC
+{
+    uint8_t flags;
+    int16_t width;
+    int16_t precision;      // -1 if not given
+} FORMAT_SPEC;
+
+typedef struct _FORMAT_BUFFER
+{
+    char* buffer;
+    uint32_t size;
+} FORMAT_BUFFER;
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+const uint32_t formatPow10[FORMAT_MAX_PRECISION + 1] =
+{
+    1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000
+};
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void formatPut(FORMAT_OUTPUT* out, char c)
+{
+    out->put(c, out->context);
+    out->count++;
+}
+
+void formatRepeat(FORMAT_OUTPUT* out, char c, int16_t count)
+{
+    while (count-- > 0)
+        formatPut(out, c);
+}
+
+// Writes value's digits backward from end, returns how many
+uint8_t formatDigits(char* end, uint64_t value, uint8_t base, bool upper)
+{
+    const char* digits = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    uint8_t length = 0;
+    uint32_t low;
+
+    while (value > 0xFFFFFFFF)
+    {
+        *--end = digits[value % base];
+        value /= base;
+        length++;
+    }
+    low = value;
+    do
+    {
+        *--end = digits[low % base];
+        low /= base;
+        length++;
+    }
+    while (low != 0);
+    return length;
+}
+
+// prefix, zeros to precision, body and trailing zeros, padded to the width
+void formatField(FORMAT_OUTPUT* out, FORMAT_SPEC* spec, const char* prefix, uint8_t prefixLength,
+                 int16_t zeros, const char* body, uint8_t bodyLength, int16_t trailing)
+{
+    int16_t pad = spec->width - prefixLength - zeros - bodyLength - trailing;
+    uint8_t i;
+
+    if (!(spec->flags & (FORMAT_LEFT | FORMAT_ZERO)))
+        formatRepeat(out, ' ', pad);
+    for (i = 0; i < prefixLength; i++)
+        formatPut(out, prefix[i]);
+    if ((spec->flags & (FORMAT_LEFT | FORMAT_ZERO)) == FORMAT_ZERO)
+        formatRepeat(out, '0', pad);
+    formatRepeat(out, '0', zeros);
+    for (i = 0; i < bodyLength; i++)
+        formatPut(out, body[i]);
+    formatRepeat(out, '0', trailing);
+    if (spec->flags & FORMAT_LEFT)
+        formatRepeat(out, ' ', pad);
+}
+
+char formatSign(FORMAT_SPEC* spec, bool negative)
+{
+    if (negative)
+        return '-';
+    if (spec->flags & FORMAT_PLUS)
+        return '+';
+    if (spec->flags & FORMAT_SPACE)
+        return ' ';
+    return 0;
+}
+
+void formatInteger(FORMAT_OUTPUT* out, FORMAT_SPEC* spec, uint64_t value, bool negative, uint8_t base, bool upper)
+{
+    char digits[FORMAT_DIGITS];
+    char prefix[2];
+    uint8_t prefixLength = 0;
+    uint8_t length = 0;
+    int16_t zeros = 0;
+
+    if (base == 10)
+    {
+        prefix[0] = formatSign(spec, negative);
+        prefixLength = (prefix[0] != 0);
+    }
+    else if ((spec->flags & FORMAT_ALT) && value != 0)
+    {
+        prefix[0] = '0';
+        prefix[1] = upper ? 'X' : 'x';
+        prefixLength = 2;
+    }
+
+    // A precision of 0 prints nothing for 0, like printf
+    if (value != 0 || spec->precision != 0)
+        length = formatDigits(&digits[FORMAT_DIGITS], value, base, upper);
+    if (spec->precision >= 0)
+    {
+        zeros = spec->precision - length;
+        spec->flags &= ~FORMAT_ZERO;
+    }
+    formatField(out, spec, prefix, prefixLength, zeros, &digits[FORMAT_DIGITS - length], length, 0);
+}
+
+// integer.fraction, fraction already scaled to precision digits (up to FORMAT_MAX_PRECISION)
+void formatFixed(FORMAT_OUTPUT* out, FORMAT_SPEC* spec, bool negative, uint64_t integer, uint32_t fraction, int16_t precision)
+{
+    char body[FORMAT_DIGITS + 1 + FORMAT_MAX_PRECISION];
+    char sign = formatSign(spec, negative);
+    uint8_t digits = (precision > FORMAT_MAX_PRECISION) ? FORMAT_MAX_PRECISION : precision;
+    uint8_t length;
+    uint8_t i;
+
+    // Fraction first, backward from the end, then the point and the integer part
+    for (i = 0; i < digits; i++)
+    {
+        body[sizeof(body) - 1 - i] = '0' + fraction % 10;
+        fraction /= 10;
+    }
+    length = digits;
+    if (precision > 0 || (spec->flags & FORMAT_ALT))
+        body[sizeof(body) - 1 - length++] = '.';
+    length += formatDigits(&body[sizeof(body) - length], integer, 10, false);
+    formatField(out, spec, &sign, sign != 0, 0, &body[sizeof(body) - length], length, precision - digits);
+}
+
+void formatText(FORMAT_OUTPUT* out, FORMAT_SPEC* spec, const char* text, uint32_t length)
+{
+    int16_t pad = spec->width - length;
+    uint32_t i;
+
+    if (!(spec->flags & FORMAT_LEFT))
+        formatRepeat(out, ' ', pad);
+    for (i = 0; i < length; i++)
+        formatPut(out, text[i]);
+    if (spec->flags & FORMAT_LEFT)
+        formatRepeat(out, ' ', pad);
+}
+
+void formatDouble(FORMAT_OUTPUT* out, FORMAT_SPEC* spec, double value)
+{
+    int16_t precision = (spec->precision < 0) ? FORMAT_DEFAULT_PRECISION : spec->precision;
+    uint8_t digits = (precision > FORMAT_MAX_PRECISION) ? FORMAT_MAX_PRECISION : precision;
+    bool negative = value < 0;
+    uint64_t integer;
+    uint32_t fraction;
+    double scaled;
+
+    if (value != value)
+    {
+        spec->flags &= ~FORMAT_ZERO;
+        formatText(out, spec, "nan", 3);
+        return;
+    }
+    if (negative)
+        value = -value;
+    if (value >= 18446744073709551616.0)
+    {
+        spec->flags &= ~FORMAT_ZERO;
+        if (value > 1.7976931348623157e308)
+            formatText(out, spec, negative ? "-inf" : "inf", 3 + negative);
+        else
+            formatText(out, spec, "ovf", 3);
+        return;
+    }
+
+    // 32-bit integer part keeps the conversions cheap on the M4
+    if (value < 4294967296.0)
+        integer = (uint32_t)value;
+    else
+        integer = (uint64_t)value;
+    scaled = (value - (double)integer) * formatPow10[digits];
+    fraction = (uint32_t)scaled;
+    scaled -= fraction;
+    if (scaled > 0.5 || (scaled == 0.5 && (((digits != 0) ? fraction : (uint32_t)integer) & 1)))
+        fraction++;
+    if (fraction >= formatPow10[digits])
+    {
+        fraction -= formatPow10[digits];
+        integer++;
+    }
+    formatFixed(out, spec, negative, integer, fraction, precision);
+}
+
+// value / 2^bits, exact
+void formatQ(FORMAT_OUTPUT* out, FORMAT_SPEC* spec, int32_t value, uint8_t bits)
+{
+    int16_t precision = spec->precision;
+    uint8_t digits;
+    bool negative = value < 0;
+    uint32_t magnitude = negative ? (uint32_t)0 - (uint32_t)value : (uint32_t)value;
+    uint64_t scaled;
+
+    // Default is the digits the resolution needs, bits * log10(2) rounded up
+    if (precision < 0)
+        precision = (bits * 3 + 9) / 10;
+    digits = (precision > FORMAT_MAX_PRECISION) ? FORMAT_MAX_PRECISION : precision;
+
+    scaled = (uint64_t)magnitude * formatPow10[digits];
+    if (bits != 0)
+        scaled = (scaled + ((uint64_t)1 << (bits - 1))) >> bits;
+    formatFixed(out, spec, negative, scaled / formatPow10[digits], scaled % formatPow10[digits], precision);
+}
+
+// Sends the formatted text to put, returns the number of characters
+uint32_t formatOutput(void (*put)(char c, void* context), void* context, const char* format, va_list args)
+{
+    FORMAT_OUTPUT out;
+    FORMAT_SPEC spec;
+    uint8_t longs;
+    uint64_t value;
+    int64_t signedValue;
+    const char* text;
+    uint32_t length;
+    uint8_t bits;
+    char character;
+    char c;
+
+    out.put = put;
+    out.context = context;
+    out.count = 0;
+
+    while (*format != '\0')
+    {
+        if (*format != '%')
+        {
+            formatPut(&out, *format++);
+            continue;
+        }
+        format++;
+
+        // Flags
+        spec.flags = 0;
+        while (true)
+        {
+            if (*format == '-')
+                spec.flags |= FORMAT_LEFT;
+            else if (*format == '0')
+                spec.flags |= FORMAT_ZERO;
+            else if (*format == '+')
+                spec.flags |= FORMAT_PLUS;
+            else if (*format == ' ')
+                spec.flags |= FORMAT_SPACE;
+            else if (*format == '#')
+                spec.flags |= FORMAT_ALT;
+            else
+                break;
+            format++;
+        }
+
+        // Width
+        spec.width = 0;
+        if (*format == '*')
+        {
+            spec.width = va_arg(args, int);
+            if (spec.width < 0)
+            {
+                spec.flags |= FORMAT_LEFT;
+                spec.width = -spec.width;
+            }
+            format++;
+        }
+        while (*format >= '0' && *format <= '9')
+            spec.width = spec.width * 10 + (*format++ - '0');
+
+        // Precision
+        spec.precision = -1;
+        if (*format == '.')
+        {
+            format++;
+            spec.precision = 0;
+            if (*format == '*')
+            {
+                spec.precision = va_arg(args, int);
+                if (spec.precision < 0)
+                    spec.precision = -1;
+                format++;
+            }
+            while (*format >= '0' && *format <= '9')
+                spec.precision = spec.precision * 10 + (*format++ - '0');
+        }
+
+        // Length, h is accepted and ignored since short arguments arrive as int
+        longs = 0;
+        while (*format == 'l' || *format == 'h')
+        {
+            if (*format == 'l')
+                longs++;
+            format++;
+        }
+
+        c = *format;
+        if (c == '\0')
+            break;
+        format++;
+
+        switch (c)
+        {
+            case 'c':
+                character = va_arg(args, int);
+                formatText(&out, &spec, &character, 1);
+                break;
+            case 's':
+                text = va_arg(args, const char*);
+                if (text == 0)
+                    text = "(null)";
+                for (length = 0; text[length] != '\0' && (spec.precision < 0 || length < (uint32_t)spec.precision); length++);
+                formatText(&out, &spec, text, length);
+                break;
+            case 'd':
+            case 'i':
+                if (longs >= 2)
+                    signedValue = va_arg(args, long long);
+                else if (longs == 1)
+                    signedValue = va_arg(args, long);
+                else
+                    signedValue = va_arg(args, int);
+                value = (signedValue < 0) ? (uint64_t)0 - (uint64_t)signedValue : (uint64_t)signedValue;
+                formatInteger(&out, &spec, value, signedValue < 0, 10, false);
+                break;
+            case 'u':
+            case 'x':
+            case 'X':
+                if (longs >= 2)
+                    value = va_arg(args, unsigned long long);
+                else if (longs == 1)
+                    value = va_arg(args, unsigned long);
+                else
+                    value = va_arg(args, unsigned int);
+                formatInteger(&out, &spec, value, false, (c == 'u') ? 10 : 16, c == 'X');
+                break;
+            case 'p':
+                spec.flags |= FORMAT_ALT;
+                spec.precision = 8;
+                formatInteger(&out, &spec, (uintptr_t)va_arg(args, void*), false, 16, false);
+                break;
+            case 'f':
+            case 'F':
+                formatDouble(&out, &spec, va_arg(args, double));
+                break;
+            case 'q':
+                bits = FORMAT_DEFAULT_Q;
+                if (*format >= '0' && *format <= '9')
+                {
+                    bits = 0;
+                    while (*format >= '0' && *format <= '9')
+                        bits = bits * 10 + (*format++ - '0');
+                    if (bits > 31)
+                        bits = 31;
+                }
+                formatQ(&out, &spec, va_arg(args, int32_t), bits);
+                break;
+            case '%':
+                formatPut(&out, '%');
+                break;
+            default:
+                formatPut(&out, '%');
+                formatPut(&out, c);
+                break;
+        }
+    }
+    return out.count;
+}
+
+void formatToBuffer(char c, void* context)
+{
+    FORMAT_BUFFER* b = context;
+
+    if (b->size > 1)
+    {
+        *b->buffer++ = c;
+        b->size--;
+    }
+}
+
+// snprintf: buffer always ends in '\0' if size isn't 0
+// Returns the length the whole text would have, so >= size means it was cut
+uint32_t vformatString(char* buffer, uint32_t size, const char* format, va_list args)
+{
+    FORMAT_BUFFER b;
+    uint32_t length;
+
+    b.buffer = buffer;
+    b.size = size;
+    length = formatOutput(formatToBuffer, &b, format, args);
+    if (size != 0)
+        *b.buffer = '\0';
+    return length;
+}
+
+uint32_t formatString(char* buffer, uint32_t size, const char* format, ...)
+{
+    va_list args;
+    uint32_t length;
+
+    va_start(args, format);
+    length = vformatString(buffer, size, format, args);
+    va_end(args);
+    return length;
+}
@@ -0,0 +1,43 @@
+// Format Library
+// Xavier
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    80 MHz
+
+// Hardware configuration: -
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef FORMAT_H_
+#define FORMAT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdarg.h>
+
+// General Defines
+#define FORMAT_DEFAULT_PRECISION 6      // %f digits after the point
+#define FORMAT_MAX_PRECISION     9      // digits computed, more are padded with zeros
+#define FORMAT_DEFAULT_Q         16     // %q fraction bits when none are given
+
+// Conversions: %c %s %d %i %u %x %X %p %f %q %%
+//   flags - 0 + space #, width and .precision (digits or *), l and ll
+//   %f takes a double (floats are promoted), %q an int32_t in Q format with
+//   the fraction bits right after the q, e.g. %.3q15 for Q15 with 3 digits
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+uint32_t formatOutput(void (*put)(char c, void* context), void* context, const char* format, va_list args);
+uint32_t vformatString(char* buffer, uint32_t size, const char* format, va_list args);
+uint32_t formatString(char* buffer, uint32_t size, const char* format, ...);
+
+#endif
@@ -7,7 +7,7 @@
 
 // Target Platform: EK-TM4C123GXL with LCD/Keyboard Interface
 // Target uC:       TM4C123GH6PM
-// System Clock:    40 MHz
+// System Clock:    80 MHz
 
 // Hardware configuration:
 // GPIO APB ports A-F
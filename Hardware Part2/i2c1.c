@@ -7,7 +7,7 @@
 
 // Target Platform: EK-TM4C123GXL
 // Target uC:       TM4C123GH6PM
-// System Clock:    40 MHz
+// System Clock:    80 MHz
 
 // Hardware configuration:
 // I2C devices on I2C bus 1 with 2kohm pullups on SDA and SCL
@@ -21,6 +21,7 @@
 #include "tm4c123gh6pm.h"
 #include "gpio.h"
 #include "i2c1.h"
+#include "clock.h"
 
 // Pins
 //#define I2C0SCL PORTB,2
@@ -29,6 +30,8 @@
 #define I2C1SCL PORTA, 6
 #define I2C1SDA PORTA, 7
 
+#define I2C1_SCL_HZ 100000
+
 //-----------------------------------------------------------------------------
 // Global variables
 //-----------------------------------------------------------------------------
@@ -53,7 +56,7 @@ void initI2c1(void)
 
     // Configure I2C1 peripheral
     I2C1_MCR_R = 0;                                     // disable to program
-    I2C1_MTPR_R = 19;                                   // (40MHz/2) / (6+4) / (19+1) = 100kbps
+    I2C1_MTPR_R = SYSTEM_CLOCK_HZ / (2 * (6 + 4) * I2C1_SCL_HZ) - 1; // (fcyc/2) / (6+4) / (TPR+1) = 100kbps
     I2C1_MCR_R = I2C_MCR_MFE;                           // master
     I2C1_MCS_R = I2C_MCS_STOP;
 }
@@ -7,7 +7,7 @@
 
 // Target Platform: EK-TM4C123GXL
 // Target uC:       TM4C123GH6PM
-// System Clock:    40 MHz
+// System Clock:    80 MHz
 
 // Hardware configuration:
 // I2C devices on I2C bus 1 with 2kohm pullups on SDA and SCL
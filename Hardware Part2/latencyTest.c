@@ -0,0 +1,138 @@
+// Latency Test Library
+// Xavier
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    80 MHz
+
+// Hardware configuration:
+// TIMER0A as the interrupt load generator, UART0 for the output load
+
+// Checks the priority plan on the robot. For the length of the test:
+//   - TIMER0A fires at random intervals at the IR decoder's priority and
+//     spends loadUs in the ISR, then prints from the ISR like IRdecoder does
+//   - the main loop keeps the UART transmit FIFO full, so those ISR prints
+//     block on it
+// The scheduler measures how late every SysTick was entered. With the plan
+// in place none of that load may delay the balance tick by more than the
+// exception entry itself.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "tm4c123gh6pm.h"
+#include "latencyTest.h"
+#include "scheduler.h"
+#include "timebase.h"
+#include "timing.h"
+#include "uart0.h"
+#include "profiler.h"
+
+#define LATENCY_MIN_INTERVAL_US 100
+#define LATENCY_MAX_INTERVAL_US 2000
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+bool latencyTestRunning = false;
+DEADLINE latencyTestEnd;
+uint32_t latencyLoadCycles = 0;
+uint32_t latencyLoadCount = 0;
+uint32_t latencyRandom = 1;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// Next load interval in cycles, LCG so the load drifts across the tick phase
+uint32_t nextLoadInterval(void)
+{
+    latencyRandom = latencyRandom * 1664525 + 1013904223;
+    return (LATENCY_MIN_INTERVAL_US + (latencyRandom >> 16) % (LATENCY_MAX_INTERVAL_US - LATENCY_MIN_INTERVAL_US)) * TIMING_CYCLES_PER_US;
+}
+
+void startLatencyTest(uint32_t seconds, uint32_t loadUs)
+{
+    latencyLoadCycles = loadUs * TIMING_CYCLES_PER_US;
+    latencyLoadCount = 0;
+    latencyTestEnd = deadlineIn(seconds * 1000000);
+    clearTickLatency();
+
+    // Configure Timer 0 as the load generator, clocked only for the test
+    SYSCTL_RCGCTIMER_R |= SYSCTL_RCGCTIMER_R0;
+    _delay_cycles(3);
+    TIMER0_CTL_R &= ~TIMER_CTL_TAEN;                 // turn-off timer before reconfiguring
+    TIMER0_CFG_R = TIMER_CFG_32_BIT_TIMER;           // configure as 32-bit timer (A+B)
+    TIMER0_TAMR_R = TIMER_TAMR_TAMR_PERIOD;          // configure for periodic mode (count down)
+    TIMER0_TAILR_R = nextLoadInterval();
+    TIMER0_ICR_R = TIMER_ICR_TATOCINT;
+    TIMER0_IMR_R = TIMER_IMR_TATOIM;                 // turn-on interrupts
+    NVIC_EN0_R = 1 << (INT_TIMER0A-16);              // turn-on interrupt 35 (TIMER0A)
+    TIMER0_CTL_R |= TIMER_CTL_TAEN;                  // turn-on timer
+
+    latencyTestRunning = true;
+}
+
+// Called from the main loop, supplies the UART load and ends the test
+void updateLatencyTest(void)
+{
+    if (!latencyTestRunning)
+        return;
+
+    if (deadlinePassed(latencyTestEnd))
+    {
+        TIMER0_CTL_R &= ~TIMER_CTL_TAEN;
+        TIMER0_IMR_R = 0;
+        NVIC_DIS0_R = 1 << (INT_TIMER0A-16);
+        SYSCTL_RCGCTIMER_R &= ~SYSCTL_RCGCTIMER_R0;
+        latencyTestRunning = false;
+
+        printfUart0("\nLatency test done, %u load interrupts\n", latencyLoadCount);
+        printTickLatency();
+        return;
+    }
+
+    putsUart0("0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef\n");
+}
+
+bool isLatencyTestRunning(void)
+{
+    return latencyTestRunning;
+}
+
+void printTickLatency(void)
+{
+    TICK_LATENCY t = getTickLatency();
+    uint8_t i;
+
+    printfUart0("tick entry latency: samples %u   max %u cycles (%u us)   %s\n", t.samples, t.max,
+                t.max / TIMING_CYCLES_PER_US, (t.max <= LATENCY_LIMIT_US * TIMING_CYCLES_PER_US) ? "PASS" : "FAIL");
+    printfUart0("  cycles <16,32,64..1024+:");
+    for (i = 0; i < TIMING_BUCKETS; i++)
+        printfUart0(" %u", t.histogram[i]);
+    printfUart0("\n");
+}
+
+// Stands in for wideTimer3Isr: busy for a while, then prints
+void latencyLoadIsr(void)
+{
+    PROFILE_MARK mark = profileEnter();
+    uint32_t start = DWT_CYCCNT_R;
+
+    TIMER0_ICR_R = TIMER_ICR_TATOCINT;
+    TIMER0_TAILR_R = nextLoadInterval();
+    latencyLoadCount++;
+
+    while ((DWT_CYCCNT_R - start) < latencyLoadCycles);
+    putsUart0("[ir]\n");
+
+    profileExit(PROFILE_LOAD, mark);
+}
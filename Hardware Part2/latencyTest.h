@@ -0,0 +1,40 @@
+// Latency Test Library
+// Xavier
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    80 MHz
+
+// Hardware configuration:
+// TIMER0A as the interrupt load generator, UART0 for the output load
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef LATENCYTEST_H_
+#define LATENCYTEST_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// General Defines
+#define LATENCY_LIMIT_US        10      // worst tick entry delay the balance loop accepts
+#define LATENCY_DEFAULT_SECONDS 10
+#define LATENCY_DEFAULT_LOAD_US 500     // busy time of each load interrupt, about one IR decode with a print
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void startLatencyTest(uint32_t seconds, uint32_t loadUs);
+void updateLatencyTest(void);
+bool isLatencyTestRunning(void);
+void printTickLatency(void);
+void latencyLoadIsr(void);
+
+#endif
@@ -0,0 +1,209 @@
+// Line Editor Library
+// Xavier
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    80 MHz
+
+// Hardware configuration:
+// UART Interface:
+//   U0TX (PA1) and U0RX (PA0) are connected to the 2nd controller
+
+// Assembles a command line from whatever the UART0 receive ring holds and
+// returns right away, so the main loop keeps running while someone types.
+// Characters are echoed as they arrive. Backspace (BS or DEL) erases, the
+// up and down arrows (ESC [ A / ESC [ B, or Ctrl-P / Ctrl-N) step through
+// the last few commands, and Ctrl-U clears the line. Enter hands the line
+// to the parser.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "lineEditor.h"
+#include "uart0.h"
+
+#define KEY_CTRL_N  14
+#define KEY_CTRL_P  16
+#define KEY_CTRL_U  21
+#define KEY_ESC     27
+
+typedef enum
+{
+    ESCAPE_NONE,
+    ESCAPE_STARTED,     // ESC received
+    ESCAPE_CSI          // ESC [ received
+} EscapeState;
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+char line[MAX_CHARS + 1];
+uint8_t lineLength = 0;
+bool linePrompted = false;              // " > " printed for this line
+EscapeState escapeState = ESCAPE_NONE;
+
+char history[LINE_HISTORY][MAX_CHARS + 1];
+uint8_t historyCount = 0;               // entries in use
+uint8_t historyNewest = 0;              // slot of the last command entered
+uint8_t historyBack = 0;                // 0 while editing, n while showing the nth previous command
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initLineEditor(void)
+{
+    lineLength = 0;
+    linePrompted = false;
+    escapeState = ESCAPE_NONE;
+    historyCount = 0;
+    historyNewest = 0;
+    historyBack = 0;
+}
+
+void promptLine(void)
+{
+    if (!linePrompted)
+    {
+        putsUart0(" > ");
+        linePrompted = true;
+    }
+}
+
+// Replaces what is on the terminal and in the line with text
+void replaceLine(const char* text)
+{
+    while (lineLength > 0)
+    {
+        putsUart0("\b \b");
+        lineLength--;
+    }
+    while ((text[lineLength] != '\0') && (lineLength < MAX_CHARS))
+    {
+        line[lineLength] = text[lineLength];
+        putcUart0(line[lineLength]);
+        lineLength++;
+    }
+}
+
+// Step 1 is older, -1 is newer
+void recallHistory(int8_t step)
+{
+    uint8_t back = historyBack + step;
+
+    if ((step > 0 && historyBack >= historyCount) || (step < 0 && historyBack == 0))
+        return;
+    historyBack = back;
+
+    promptLine();
+    if (historyBack == 0)
+        replaceLine("");
+    else
+        replaceLine(history[(historyNewest + LINE_HISTORY - (historyBack - 1)) % LINE_HISTORY]);
+}
+
+void saveHistory(void)
+{
+    uint8_t i;
+
+    // Don't fill the history with the same command run over and over
+    if (historyCount > 0 && customStrcmp(line, history[historyNewest]))
+        return;
+
+    if (historyCount > 0)
+        historyNewest = (historyNewest + 1) % LINE_HISTORY;
+    for (i = 0; i <= lineLength; i++)
+        history[historyNewest][i] = line[i];
+    if (historyCount < LINE_HISTORY)
+        historyCount++;
+}
+
+// Consumes the characters received so far
+// Returns true with the finished line in data->buffer when enter was pressed,
+// anything after it stays in the receive ring for the next call
+bool updateLineEditor(USER_DATA* data)
+{
+    char c;
+    uint8_t i;
+
+    while (kbhitUart0())
+    {
+        c = getcUart0();
+
+        if (escapeState == ESCAPE_STARTED)
+        {
+            escapeState = (c == '[') ? ESCAPE_CSI : ESCAPE_NONE;
+            continue;
+        }
+        if (escapeState == ESCAPE_CSI)
+        {
+            escapeState = ESCAPE_NONE;
+            if (c == 'A')
+                recallHistory(1);
+            else if (c == 'B')
+                recallHistory(-1);
+            continue;
+        }
+
+        if (c == KEY_ESC)
+        {
+            escapeState = ESCAPE_STARTED;
+        }
+        else if (c == KEY_CTRL_P)
+        {
+            recallHistory(1);
+        }
+        else if (c == KEY_CTRL_N)
+        {
+            recallHistory(-1);
+        }
+        else if (c == KEY_CTRL_U)
+        {
+            replaceLine("");
+            historyBack = 0;
+        }
+        else if (c == 8 || c == 127)
+        {
+            if (lineLength > 0)
+            {
+                lineLength--;
+                putsUart0("\b \b");
+            }
+        }
+        else if (c == 13)
+        {
+            if (!linePrompted)
+                continue;               // a bare enter just gets a fresh prompt next time
+            putsUart0("\n");
+            linePrompted = false;
+            historyBack = 0;
+            if (lineLength == 0)
+                continue;
+
+            line[lineLength] = '\0';
+            saveHistory();
+            for (i = 0; i <= lineLength; i++)
+                data->buffer[i] = line[i];
+            lineLength = 0;
+            return true;
+        }
+        else if (c >= 32 && c < 127)
+        {
+            promptLine();
+            if (lineLength < MAX_CHARS)
+            {
+                line[lineLength++] = c;
+                putcUart0(c);
+            }
+        }
+    }
+    return false;
+}
@@ -0,0 +1,37 @@
+// Line Editor Library
+// Xavier
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    80 MHz
+
+// Hardware configuration:
+// UART Interface:
+//   U0TX (PA1) and U0RX (PA0) are connected to the 2nd controller
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef LINEEDITOR_H_
+#define LINEEDITOR_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "uart0.h"
+
+// General Defines
+#define LINE_HISTORY    4       // previous commands kept for up/down arrow
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initLineEditor(void);
+bool updateLineEditor(USER_DATA* data);
+
+#endif
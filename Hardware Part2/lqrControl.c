@@ -0,0 +1,49 @@
+// LQR Balance Controller Library
+// Xavier
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    80 MHz
+
+// Hardware configuration: -
+
+// Full-state feedback u = -K x for the inverted pendulum on wheels.
+// K comes from lqrGains.h, which tools/lqr_gains.py generates from the robot
+// mass, wheel radius, CoM height and control period. Regenerate it whenever
+// one of those changes, including the balance rate.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include "lqrControl.h"
+#include "lqrGains.h"
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+const float lqrGain[LQR_STATES] = {LQR_K_TILT, LQR_K_TILT_RATE, LQR_K_POSITION, LQR_K_VELOCITY};
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// Returns the normalized motor command, -1 (full reverse) to 1 (full forward)
+float computeLqrOutput(const float state[LQR_STATES])
+{
+    uint8_t i;
+    float u = 0;
+
+    for (i = 0; i < LQR_STATES; i++)
+        u -= lqrGain[i] * state[i];
+
+    if (u > 1) u = 1;
+    if (u < -1) u = -1;
+    return u;
+}
@@ -0,0 +1,36 @@
+// LQR Balance Controller Library
+// Xavier
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    80 MHz
+
+// Hardware configuration: -
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef LQRCONTROL_H_
+#define LQRCONTROL_H_
+
+#include <stdint.h>
+
+// General Defines
+#define LQR_STATES    4
+#define LQR_TILT      0     // rad, positive leaning backward
+#define LQR_TILT_RATE 1     // rad/s
+#define LQR_POSITION  2     // m, forward
+#define LQR_VELOCITY  3     // m/s, forward
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+float computeLqrOutput(const float state[LQR_STATES]);
+
+#endif
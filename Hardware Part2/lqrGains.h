@@ -0,0 +1,20 @@
+// LQR Gains
+// Generated by tools/lqr_gains.py, do not edit
+
+// default parameters
+// mass 1.000 kg, wheel mass 0.050 kg, radius 0.0640 m, CoM 0.100 m
+// stall torque 0.300 Nm, no-load speed 20.0 rad/s, period 0.0250 s
+// Q = diag(100, 1, 10, 1), R = 1
+
+#ifndef LQRGAINS_H_
+#define LQRGAINS_H_
+
+#define LQR_PERIOD 0.025000
+#define LQR_PERIOD_MS 25      // has to match the balance task, Project.c checks it
+
+#define LQR_K_TILT       4.483452
+#define LQR_K_TILT_RATE  0.418077
+#define LQR_K_POSITION   -0.707636
+#define LQR_K_VELOCITY   -1.517598
+
+#endif
@@ -15,20 +15,42 @@
 // Device includes, defines, and assembler directives
 //-----------------------------------------------------------------------------
 
+#include <stdbool.h>
 #include "motorControl.h"
 #include "tm4c123gh6pm.h"
 #include "gpio.h"
-#include "wait.h"
+#include "timebase.h"
+#include "clock.h"
 
 #define OUT_PWM_1       PORTC, 4 // M0PWM6
 #define OUT_PWM_2       PORTC, 5 // M0PWM7
 #define OUT_PWM_3       PORTB, 6 // M0PWM0
 #define OUT_PWM_4       PORTB, 7 // M0PWM1
+#define OUT_ENABLE      PORTE, 0 // P30
+
+#define MOTOR_KICK_US      100000   // full power to break static friction
+#define MOTOR_SLOW_STEP_US 50000    // time between slow-down steps
+#define MOTOR_SLOW_STEP    50       // duty removed per step
+#define MOTOR_SLOW_STOP    200      // duty where the ramp gives up and stops
 
 //-----------------------------------------------------------------------------
 // Global variables
 //-----------------------------------------------------------------------------
 
+typedef enum
+{
+    RAMP_IDLE,
+    RAMP_KICK_BOTH,     // kick, then setDirection(rampDirection, rampA, rampB)
+    RAMP_KICK_WHEEL,    // kick, then setPwmDutyCycle(rampSide, rampA, rampB)
+    RAMP_SLOW           // step rampA/rampB down in rampDirection, then stop
+} RampMode;
+
+volatile RampMode rampMode = RAMP_IDLE;
+DEADLINE rampDeadline;
+uint8_t rampDirection;
+uint8_t rampSide;
+uint16_t rampA;
+uint16_t rampB;
 
 
 //-----------------------------------------------------------------------------
@@ -74,8 +96,8 @@ void initPWM(void)
     PWM0_3_GENA_R = PWM_0_GENA_ACTCMPAD_ZERO | PWM_0_GENA_ACTLOAD_ONE; // output 6 on PWM0, gen 3a, cmpa // Pg. 1282
     PWM0_3_GENB_R = PWM_0_GENB_ACTCMPBD_ZERO | PWM_0_GENB_ACTLOAD_ONE; // output 7 on PWM0, gen 3b, cmpb // Pg. 1282
 
-    PWM0_0_LOAD_R = 1024; // set frequency to 40 MHz sys clock / 2 / 1024 = 19.53125 kHz
-    PWM0_3_LOAD_R = 1024; // set frequency to 40 MHz sys clock / 2 / 1024 = 19.53125 kHz
+    PWM0_0_LOAD_R = 1024; // set frequency to PWM_CLOCK_HZ / 1024, the clock is 40 MHz at 80 and 40 MHz sys clock
+    PWM0_3_LOAD_R = 1024; // set frequency to PWM_CLOCK_HZ / 1024, the clock is 40 MHz at 80 and 40 MHz sys clock
 
     // invert outputs so duty cycle increases with increasing compare values
     PWM0_INVERT_R = PWM_INVERT_PWM0INV | PWM_INVERT_PWM1INV | PWM_INVERT_PWM6INV | PWM_INVERT_PWM7INV;
@@ -144,49 +166,123 @@ void setDirection(uint8_t direction, uint16_t pwmL, uint16_t pwmR)
     }
 }
 
+// Starts a ramp from pwmL/pwmR down to a stop, the motor task's updateMotorRamp() does the steps,
+// the first on its next run
 void slowDown(uint8_t direction, uint16_t pwmL, uint16_t pwmR)
 {
-    uint16_t pwmLval = pwmL;
-    uint16_t pwmRval = pwmR;
+    rampMode = RAMP_IDLE;
+    rampDirection = direction;
+    rampA = pwmL;
+    rampB = pwmR;
+    rampDeadline = nowUs();
+    rampMode = RAMP_SLOW;
+}
 
-    uint32_t microSeconds = 50000; // 100000
+// Full power on both wheels for MOTOR_KICK_US, then pwmL/pwmR
+void kickDirection(uint8_t direction, uint16_t pwmL, uint16_t pwmR)
+{
+    rampMode = RAMP_IDLE;
+    setDirection(direction, 1023, 1023);
+    rampDirection = direction;
+    rampA = pwmL;
+    rampB = pwmR;
+    rampDeadline = deadlineIn(MOTOR_KICK_US);
+    rampMode = RAMP_KICK_BOTH;
+}
 
-    switch(direction)
-    {
-        case 0: // Backwards
-            while ((pwmLval > 200) && (pwmRval > 200))
-            {
-                pwmLval -= 50;
-                pwmRval -= 50;
+// Full power on one wheel for MOTOR_KICK_US, then pwmA/pwmB (one of them 0)
+void kickWheel(uint8_t side, uint16_t pwmA, uint16_t pwmB)
+{
+    rampMode = RAMP_IDLE;
+    setPwmDutyCycle(side, pwmA ? 1023 : 0, pwmB ? 1023 : 0);
+    rampSide = side;
+    rampA = pwmA;
+    rampB = pwmB;
+    rampDeadline = deadlineIn(MOTOR_KICK_US);
+    rampMode = RAMP_KICK_WHEEL;
+}
 
-                PWM0_0_CMPA_R = 0;
-                PWM0_0_CMPB_R = pwmLval;
-                PWM0_3_CMPA_R = pwmRval;
-                PWM0_3_CMPB_R = 0;
+// Called periodically, finishes kicks and steps the slow-down ramp
+void updateMotorRamp(void)
+{
+    switch(rampMode)
+    {
+        case RAMP_IDLE:
+        break;
 
-                waitMicrosecond(microSeconds);
+        case RAMP_KICK_BOTH:
+            if (deadlinePassed(rampDeadline))
+            {
+                rampMode = RAMP_IDLE;
+                setDirection(rampDirection, rampA, rampB);
             }
         break;
 
-        case 1: // Forward
-            while ((pwmLval > 200) && (pwmRval > 200))
+        case RAMP_KICK_WHEEL:
+            if (deadlinePassed(rampDeadline))
             {
-                pwmLval -= 50;
-                pwmRval -= 50;
-
-                PWM0_0_CMPA_R = pwmLval;
-                PWM0_0_CMPB_R = 0;
-                PWM0_3_CMPA_R = 0;
-                PWM0_3_CMPB_R = pwmRval;
+                rampMode = RAMP_IDLE;
+                setPwmDutyCycle(rampSide, rampA, rampB);
+            }
+        break;
 
-                waitMicrosecond(microSeconds);
+        case RAMP_SLOW:
+            if (deadlineAdvance(&rampDeadline, MOTOR_SLOW_STEP_US))
+            {
+                if ((rampA > MOTOR_SLOW_STOP) && (rampB > MOTOR_SLOW_STOP))
+                {
+                    rampA -= MOTOR_SLOW_STEP;
+                    rampB -= MOTOR_SLOW_STEP;
+                    setDirection(rampDirection, rampA, rampB);
+                }
+                else
+                {
+                    turnOffAll();
+                }
             }
         break;
     }
 }
 
+// True while a kick or slow-down owns the motors
+bool isMotorRampBusy(void)
+{
+    return rampMode != RAMP_IDLE;
+}
+
+// Direction the wheel is being driven, read back from the compare registers
+// Returns 1 (forward), -1 (backward) or 0 (not driven)
+int8_t getWheelDirection(uint8_t side)
+{
+    switch(side)
+    {
+        case 0: // Left Wheel
+            if (PWM0_0_CMPA_R > PWM0_0_CMPB_R) return 1;
+            if (PWM0_0_CMPB_R > PWM0_0_CMPA_R) return -1;
+            break;
+        case 1: // Right Wheel
+            if (PWM0_3_CMPB_R > PWM0_3_CMPA_R) return 1;
+            if (PWM0_3_CMPA_R > PWM0_3_CMPB_R) return -1;
+            break;
+    }
+    return 0;
+}
+
+// Last resort from the watchdog and fault handlers: motors off and driver disabled
+// Only register writes, nothing here may depend on state that could be corrupt
+void safeMotors(void)
+{
+    PWM0_0_CMPA_R = 0;
+    PWM0_0_CMPB_R = 0;
+    PWM0_3_CMPA_R = 0;
+    PWM0_3_CMPB_R = 0;
+    setPinValue(OUT_ENABLE, 0);
+}
+
+// Also cancels any kick or slow-down in progress
 void turnOffAll(void)
 {
+    rampMode = RAMP_IDLE;
     PWM0_0_CMPA_R = 0; // Left Wheel
     PWM0_0_CMPB_R = 0; // Left Wheel
     PWM0_3_CMPA_R = 0; // Right Wheel
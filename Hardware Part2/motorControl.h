@@ -19,6 +19,7 @@
 #define MOTORCONTROL_H_
 
 #include <stdint.h>
+#include <stdbool.h>
 
 //-----------------------------------------------------------------------------
 // Subroutines
@@ -30,7 +31,13 @@ void setPwmDutyCycle(uint8_t side, uint16_t pwmA, uint16_t pwmB);
 void setDirectionOld(uint8_t side, uint16_t pwmAL, uint16_t pwmBL, uint16_t pwmAR, uint16_t pwmBR);
 void setDirection(uint8_t direction, uint16_t pwmL, uint16_t pwmR);
 void slowDown(uint8_t direction, uint16_t pwmL, uint16_t pwmR);
+void kickDirection(uint8_t direction, uint16_t pwmL, uint16_t pwmR);
+void kickWheel(uint8_t side, uint16_t pwmA, uint16_t pwmB);
+void updateMotorRamp(void);
+bool isMotorRampBusy(void);
+int8_t getWheelDirection(uint8_t side);
 
 void turnOffAll(void);
+void safeMotors(void);
 
 #endif
@@ -0,0 +1,122 @@
+// Odometry Library
+// Xavier
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    80 MHz
+
+// Hardware configuration:
+// OPB876N55 optical interrupters on both wheels, MPU6050 gyro z axis for yaw
+
+// The interrupters can't tell which way a tab went by, so every edge is signed
+// with the direction the wheel is being driven. When the motors are off the
+// wheel keeps the sign it had last, which covers coasting to a stop.
+// Increments the slip monitor doesn't trust are rebuilt or ignored for heading.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <math.h>
+#include "odometry.h"
+#include "motorControl.h"
+#include "slipMonitor.h"
+
+#define PI 3.1415
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+volatile int32_t wheelCount[2];   // signed tab counts since power-on
+int8_t lastWheelDirection[2];     // sign used when the wheel isn't driven
+int32_t prevWheelCount[2];        // counts at the previous update
+
+POSE pose;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initOdometry(void)
+{
+    uint8_t i;
+    for (i = 0; i < 2; i++)
+    {
+        wheelCount[i] = 0;
+        lastWheelDirection[i] = 1;
+        prevWheelCount[i] = 0;
+    }
+    initSlipMonitor();
+    resetPose();
+}
+
+// Called from the capture ISR for every accepted edge
+void countWheelEdge(uint8_t side)
+{
+    int8_t direction = getWheelDirection(side);
+    if (direction != 0)
+        lastWheelDirection[side] = direction;
+    wheelCount[side] += lastWheelDirection[side];
+}
+
+// Called once per control period with the gyro z rate in deg/s and accel x in g
+void updateOdometry(float gyroZ, float accelX, float dt)
+{
+    int32_t left = wheelCount[LEFT_WHEEL];
+    int32_t right = wheelCount[RIGHT_WHEEL];
+
+    float dLeft = (left - prevWheelCount[LEFT_WHEEL]) * ODOMETRY_CM_PER_TAB;
+    float dRight = (right - prevWheelCount[RIGHT_WHEEL]) * ODOMETRY_CM_PER_TAB;
+
+    prevWheelCount[LEFT_WHEEL] = left;
+    prevWheelCount[RIGHT_WHEEL] = right;
+
+    uint8_t flags = checkWheelConsistency(&dLeft, &dRight, gyroZ, accelX, dt);
+
+    // Heading from the wheels is coarse (1 tab = 7 degrees), the gyro is fine
+    // but drifts, so blend the two increments, unless the wheels are slipping
+    float gyroWeight = (flags & SLIP_FLAG_SLIP) ? 1.0 : ODOMETRY_GYRO_WEIGHT;
+    float dThetaWheels = (dRight - dLeft) / ODOMETRY_WHEEL_BASE;
+    float dThetaGyro = ODOMETRY_GYRO_SIGN * gyroZ * dt * PI / 180.0;
+    float dTheta = gyroWeight * dThetaGyro + (1 - gyroWeight) * dThetaWheels;
+
+    // Advance along the mid-point heading of this period
+    // Slipping wheels overstate the distance, use the accelerometer velocity instead
+    float distance = (flags & SLIP_FLAG_SLIP) ? getSlipVelocity() * dt : (dLeft + dRight) / 2;
+    float heading = pose.theta + dTheta / 2;
+    pose.x += distance * cosf(heading);
+    pose.y += distance * sinf(heading);
+
+    pose.theta += dTheta;
+    if (pose.theta > PI) pose.theta -= 2 * PI;
+    if (pose.theta < -PI) pose.theta += 2 * PI;
+}
+
+void resetPose(void)
+{
+    pose.x = 0;
+    pose.y = 0;
+    pose.theta = 0;
+}
+
+POSE getPose(void)
+{
+    return pose;
+}
+
+// Sign the wheel's edges are currently counted with
+int8_t getWheelSign(uint8_t side)
+{
+    return lastWheelDirection[side];
+}
+
+int32_t getWheelCount(uint8_t side)
+{
+    return wheelCount[side];
+}
@@ -0,0 +1,54 @@
+// Odometry Library
+// Xavier
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    80 MHz
+
+// Hardware configuration:
+// OPB876N55 optical interrupters on both wheels, MPU6050 gyro z axis for yaw
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef ODOMETRY_H_
+#define ODOMETRY_H_
+
+#include <stdint.h>
+
+// General Defines
+#define ODOMETRY_CM_PER_TAB  1.0     // 40 tabs per wheel // 1 tab = 1 cm
+#define ODOMETRY_WHEEL_BASE  16.0    // cm between the two tire centers
+#define ODOMETRY_GYRO_WEIGHT 0.9     // share of each heading update taken from the gyro
+#define ODOMETRY_GYRO_SIGN   1.0     // set to -1.0 if the MPU6050 is mounted upside down
+
+#define LEFT_WHEEL  0
+#define RIGHT_WHEEL 1
+
+// Structs
+// x is forward at power-on, y is to the left, theta is CCW positive
+typedef struct _POSE
+{
+    float x;     // cm
+    float y;     // cm
+    float theta; // radians
+} POSE;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initOdometry(void);
+void countWheelEdge(uint8_t side);
+void updateOdometry(float gyroZ, float accelX, float dt);
+void resetPose(void);
+POSE getPose(void);
+int8_t getWheelSign(uint8_t side);
+int32_t getWheelCount(uint8_t side);
+
+#endif
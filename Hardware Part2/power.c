@@ -0,0 +1,201 @@
+// Power Library
+// Xavier
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    80 MHz
+
+// Hardware configuration:
+// Wake sources: IR receiver (WTIMER3A), UART0 RX, push buttons PF4 and PF0
+// Motor driver enable on PE0
+
+// Two levels:
+//   - idleSleep(): the main loop has nothing to do, so WFI until the next
+//     interrupt. Everything keeps its clock and the SysTick that wakes us
+//     runs the balance loop as usual. Interrupts are masked around the WFI
+//     so the wake-up can be timed before the ISR runs: SysTick's
+//     RELOAD - CURRENT at that point is the wake latency in cycles.
+//   - park(): motors disabled, scheduler stopped, and with auto clock gating
+//     only the wake sources and the timebase stay clocked while asleep (not
+//     the watchdog, so it doesn't expire while the tasks are stopped).
+//     Deep sleep would drop the clock to the 16 MHz crystal under the UART
+//     and the IR capture, so park uses sleep with gating instead and the
+//     baud rate and IR pulse widths keep working.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "tm4c123gh6pm.h"
+#include "power.h"
+#include "gpio.h"
+#include "scheduler.h"
+#include "timebase.h"
+#include "timing.h"
+#include "motorControl.h"
+#include "uart0.h"
+#include "watchdog.h"
+#include "crash.h"
+#include "events.h"
+
+#define OUT_ENABLE      PORTE, 0
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+POWER_STATS powerStats;
+volatile WakeSource parkWake = WAKE_NONE;
+bool parked = false;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// Called from the main loop when there is nothing to do
+void idleSleep(void)
+{
+    uint64_t start;
+    uint32_t wake;
+    uint8_t bucket = 0;
+
+    __asm(" CPSID I");
+
+    // An event posted since the main loop looked would wait for the next tick
+    if (eventsPending())
+    {
+        __asm(" CPSIE I");
+        return;
+    }
+
+    start = nowTicks();
+    __asm(" WFI");
+
+    // Still masked, the interrupt that woke us is pending but hasn't run
+    if (NVIC_INT_CTRL_R & NVIC_INT_CTRL_PENDSTSET)
+    {
+        wake = NVIC_ST_RELOAD_R - NVIC_ST_CURRENT_R;
+        powerStats.tickWakes++;
+        powerStats.totalWake += wake;
+        if (wake > powerStats.maxWake)
+            powerStats.maxWake = wake;
+        wake >>= 4;
+        while (wake != 0 && bucket < TIMING_BUCKETS - 1)
+        {
+            wake >>= 1;
+            bucket++;
+        }
+        powerStats.wakeHistogram[bucket]++;
+    }
+    powerStats.sleeps++;
+    powerStats.sleepTicks += nowTicks() - start;
+
+    __asm(" CPSIE I");
+}
+
+// Parks the robot until an IR code, a character or a button press arrives
+void park(void)
+{
+    uint64_t start;
+    uint32_t wakeCycles;
+
+    // Safe the robot
+    turnOffAll();
+    setPinValue(OUT_ENABLE, 0);
+    stopScheduler();
+
+    // The watchdog isn't clocked while asleep, only the short wakes count
+    feedWatchdog();
+
+    // The UART receive and button interrupts are always on, they post events
+    // and call wakeFromPark()
+
+    // Only the wake sources and the timebase keep a clock while asleep
+    // The sleep gating registers use the same bits as the RCGC ones
+    SYSCTL_SCGCGPIO_R = SYSCTL_RCGCGPIO_R0 | SYSCTL_RCGCGPIO_R3 | SYSCTL_RCGCGPIO_R5;  // UART0, IR and button pins
+    SYSCTL_SCGCUART_R = SYSCTL_RCGCUART_R0;
+    SYSCTL_SCGCWTIMER_R = SYSCTL_RCGCWTIMER_R2 | SYSCTL_RCGCWTIMER_R3;                  // timebase, IR
+    SYSCTL_SCGCTIMER_R = 0;
+    SYSCTL_SCGCI2C_R = 0;
+    SYSCTL_SCGCPWM_R = 0;
+    SYSCTL_RCC_R |= SYSCTL_RCC_ACG;
+
+    traceEvent(TRACE_PARK, 1);
+    parkWake = WAKE_NONE;
+    parked = true;
+    start = nowTicks();
+    while (parkWake == WAKE_NONE)
+    {
+        __asm(" CPSID I");
+        if (parkWake == WAKE_NONE)
+            __asm(" WFI");
+        __asm(" CPSIE I");
+    }
+    wakeCycles = DWT_CYCCNT_R;
+    parked = false;
+
+    // Back to full clocks and running control loops
+    SYSCTL_RCC_R &= ~SYSCTL_RCC_ACG;
+
+    feedWatchdog();
+    traceEvent(TRACE_PARK, 0);
+    setPinValue(OUT_ENABLE, 1);
+    startScheduler();
+
+    powerStats.parks++;
+    powerStats.lastParkMs = (nowTicks() - start) / (TIMEBASE_TICKS_PER_US * 1000);
+    powerStats.lastParkExit = DWT_CYCCNT_R - wakeCycles;
+    powerStats.lastWake = parkWake;
+}
+
+// Called by the wake source ISRs, does nothing unless parked
+void wakeFromPark(WakeSource source)
+{
+    if (parked && parkWake == WAKE_NONE)
+        parkWake = source;
+}
+
+POWER_STATS getPowerStats(void)
+{
+    return powerStats;
+}
+
+void clearPowerStats(void)
+{
+    uint8_t i;
+
+    powerStats.sleeps = 0;
+    powerStats.sleepTicks = 0;
+    powerStats.startTicks = nowTicks();
+    powerStats.tickWakes = 0;
+    powerStats.maxWake = 0;
+    powerStats.totalWake = 0;
+    for (i = 0; i < TIMING_BUCKETS; i++)
+        powerStats.wakeHistogram[i] = 0;
+}
+
+void printPowerStats(void)
+{
+    POWER_STATS p = powerStats;
+    uint64_t total = nowTicks() - p.startTicks;
+    uint32_t tenths = (total == 0) ? 0 : p.sleepTicks * 1000 / total;
+    uint8_t i;
+
+    printfUart0("asleep %u.%u%% of %u s   sleeps %u\n", tenths / 10, tenths % 10,
+                (uint32_t)(total / (TIMEBASE_TICKS_PER_US * 1000000)), p.sleeps);
+    printfUart0("tick wake cycles   avg %u   max %u (%u us)\n", p.tickWakes ? (uint32_t)(p.totalWake / p.tickWakes) : 0,
+                p.maxWake, p.maxWake / TIMING_CYCLES_PER_US);
+    printfUart0("  cycles <16,32,64..1024+:");
+    for (i = 0; i < TIMING_BUCKETS; i++)
+        printfUart0(" %u", p.wakeHistogram[i]);
+    printfUart0("\n");
+    if (p.parks != 0)
+        printfUart0("parks %u   last %u ms   woken by %s   back in control after %u cycles\n", p.parks, p.lastParkMs,
+                    (p.lastWake == WAKE_IR) ? "ir" : (p.lastWake == WAKE_UART) ? "uart" : "button", p.lastParkExit);
+}
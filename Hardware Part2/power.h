@@ -0,0 +1,62 @@
+// Power Library
+// Xavier
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    80 MHz
+
+// Hardware configuration:
+// Wake sources: IR receiver (WTIMER3A), UART0 RX, push buttons PF4 and PF0
+// Motor driver enable on PE0
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef POWER_H_
+#define POWER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "timing.h"
+
+// Structs
+typedef enum
+{
+    WAKE_NONE,
+    WAKE_IR,
+    WAKE_UART,
+    WAKE_BUTTON
+} WakeSource;
+
+typedef struct _POWER_STATS
+{
+    uint32_t sleeps;                           // WFIs in the main loop
+    uint64_t sleepTicks;                       // timebase ticks spent in them
+    uint64_t startTicks;                       // timebase when the stats were cleared
+    uint32_t tickWakes;                        // sleeps ended by SysTick
+    uint32_t maxWake;                          // cycles from the tick to the CPU running again
+    uint64_t totalWake;
+    uint32_t wakeHistogram[TIMING_BUCKETS];    // <16, <32, <64 ... >=1024 cycles
+    uint32_t parks;
+    uint32_t lastParkMs;                       // time spent in the last park
+    uint32_t lastParkExit;                     // cycles from waking to the control loops running
+    WakeSource lastWake;
+} POWER_STATS;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void idleSleep(void);
+void park(void);
+void wakeFromPark(WakeSource source);
+POWER_STATS getPowerStats(void);
+void clearPowerStats(void);
+void printPowerStats(void);
+
+#endif
@@ -0,0 +1,46 @@
+// Interrupt Priorities Library
+// Xavier
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    80 MHz
+
+// Hardware configuration: -
+
+// The balance loop must never wait behind anything else, so it owns the top
+// level. Motor mixing is deferred work that feeds the motors, then come the
+// edge captures (their timestamps are latched by hardware, so they can wait)
+// and the IR decoder, which is the slowest ISR. UART and the CLI come last.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include "tm4c123gh6pm.h"
+#include "priorities.h"
+#include "nvic.h"
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// Call before any interrupt is enabled
+void initPriorities(void)
+{
+    // System exceptions
+    NVIC_SYS_PRI3_R = (NVIC_SYS_PRI3_R & ~(NVIC_SYS_PRI3_TICK_M | NVIC_SYS_PRI3_PENDSV_M))
+                    | (PRIORITY_BALANCE << NVIC_SYS_PRI3_TICK_S) | (PRIORITY_MOTOR << NVIC_SYS_PRI3_PENDSV_S);
+
+    // Peripheral interrupts
+    setNvicInterruptPriority(INT_WTIMER1A, PRIORITY_ENCODER);
+    setNvicInterruptPriority(INT_WTIMER5A, PRIORITY_ENCODER);
+    setNvicInterruptPriority(INT_WTIMER3A, PRIORITY_IR);
+    setNvicInterruptPriority(INT_TIMER0A, PRIORITY_LOAD);
+    setNvicInterruptPriority(INT_GPIOF, PRIORITY_BUTTON);
+    setNvicInterruptPriority(INT_UART0, PRIORITY_UART);
+}
@@ -0,0 +1,39 @@
+// Interrupt Priorities Library
+// Xavier
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    80 MHz
+
+// Hardware configuration: -
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef PRIORITIES_H_
+#define PRIORITIES_H_
+
+#include <stdint.h>
+
+// Priority plan, 0 is the highest and 7 the lowest
+// Every interrupt the program enables gets its level from here
+#define PRIORITY_BALANCE  0     // SysTick: IMU read and balance task
+#define PRIORITY_MOTOR    1     // PendSV: straight PID, motor ramps, other deferred tasks
+#define PRIORITY_ENCODER  2     // WTIMER1A/WTIMER5A wheel edge capture
+#define PRIORITY_IR       3     // WTIMER3A IR decoder, may print
+#define PRIORITY_LOAD     3     // TIMER0A latency test load, stands in for the IR decoder
+#define PRIORITY_BUTTON   5     // GPIOF push buttons, wake from park
+#define PRIORITY_UART     6     // UART0, the CLI itself runs in main
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initPriorities(void);
+
+#endif
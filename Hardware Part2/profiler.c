@@ -0,0 +1,181 @@
+// CPU Profiler Library
+// Xavier
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    80 MHz
+
+// Hardware configuration:
+// Cortex-M4 DWT cycle counter
+
+// Every ISR and task is bracketed by profileEnter() and profileExit(). Each
+// slot is charged only its own cycles: whatever ran nested inside it (a
+// higher priority interrupt, or the tasks the scheduler ISRs run) is taken
+// back out. profileNested holds the total of those exclusive times, so a
+// section subtracts whatever was added to it while it ran.
+// Idle is what's left, mostly the core asleep in WFI in idleSleep(), since the
+// main loop and CLI have slots of their own.
+// A snapshot of the running totals is taken every second, top reports the
+// difference between the newest snapshot and one up to PROFILE_WINDOWS back.
+// The 32-bit totals wrap after 2^32 / SYSTEM_CLOCK_HZ, about 53 s at 80 MHz,
+// still far longer than the window.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "tm4c123gh6pm.h"
+#include "profiler.h"
+#include "timing.h"
+#include "uart0.h"
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+char* profileName[PROFILE_SLOTS];
+volatile uint32_t profileCycles[PROFILE_SLOTS];   // exclusive cycles since power-on
+volatile uint32_t profileCalls[PROFILE_SLOTS];
+volatile uint32_t profileNested = 0;
+
+typedef struct _PROFILE_SNAPSHOT
+{
+    uint32_t time;                      // CYCCNT
+    uint32_t cycles[PROFILE_SLOTS];
+    uint32_t calls[PROFILE_SLOTS];
+} PROFILE_SNAPSHOT;
+
+PROFILE_SNAPSHOT profileSnapshot[PROFILE_WINDOWS + 1];
+uint8_t profileHead = 0;        // newest snapshot
+uint8_t profileSnapshots = 0;   // valid snapshots
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// DWT must already be running (initTiming)
+void initProfiler(void)
+{
+    uint8_t i;
+
+    for (i = 0; i < PROFILE_SLOTS; i++)
+    {
+        profileName[i] = 0;
+        profileCycles[i] = 0;
+        profileCalls[i] = 0;
+    }
+    profileNested = 0;
+    profileHead = 0;
+    profileSnapshots = 0;
+
+    registerProfileSlot(PROFILE_TICK, "systick");
+    registerProfileSlot(PROFILE_PENDSV, "pendsv");
+    registerProfileSlot(PROFILE_WHEEL_LEFT, "wheel L isr");
+    registerProfileSlot(PROFILE_WHEEL_RIGHT, "wheel R isr");
+    registerProfileSlot(PROFILE_IR, "ir isr");
+    registerProfileSlot(PROFILE_LOAD, "load isr");
+    registerProfileSlot(PROFILE_MAIN, "main");
+    registerProfileSlot(PROFILE_CLI, "cli");
+
+    takeProfileSnapshot();
+}
+
+void registerProfileSlot(uint8_t slot, char* name)
+{
+    profileName[slot] = name;
+}
+
+PROFILE_MARK profileEnter(void)
+{
+    PROFILE_MARK mark;
+    mark.nested = profileNested;
+    mark.start = DWT_CYCCNT_R;
+    return mark;
+}
+
+// A preemption between the read of CYCCNT and the update of profileNested
+// is charged to the wrong slot, a few cycles at most
+void profileExit(uint8_t slot, PROFILE_MARK mark)
+{
+    uint32_t exclusive = (DWT_CYCCNT_R - mark.start) - (profileNested - mark.nested);
+    profileCycles[slot] += exclusive;
+    profileCalls[slot]++;
+    profileNested += exclusive;
+}
+
+// Called once a second by the scheduler
+void takeProfileSnapshot(void)
+{
+    uint8_t i;
+    uint8_t next = (profileSnapshots == 0) ? 0 : (profileHead + 1) % (PROFILE_WINDOWS + 1);
+    PROFILE_SNAPSHOT* s = &profileSnapshot[next];
+
+    s->time = DWT_CYCCNT_R;
+    for (i = 0; i < PROFILE_SLOTS; i++)
+    {
+        s->cycles[i] = profileCycles[i];
+        s->calls[i] = profileCalls[i];
+    }
+
+    profileHead = next;
+    if (profileSnapshots < PROFILE_WINDOWS + 1)
+        profileSnapshots++;
+}
+
+void printPercent(uint32_t cycles, uint32_t total)
+{
+    uint32_t tenths = (total == 0) ? 0 : (uint64_t)cycles * 1000 / total;
+    printfUart0("%u.%u%%", tenths / 10, tenths % 10);
+}
+
+// Load over the last seconds (1 to PROFILE_WINDOWS)
+void printProfile(uint8_t seconds)
+{
+    PROFILE_SNAPSHOT newest;
+    PROFILE_SNAPSHOT* oldest;
+    uint32_t total;
+    uint32_t busy = 0;
+    uint32_t cycles, calls;
+    uint8_t i;
+
+    if (seconds > profileSnapshots - 1)
+        seconds = profileSnapshots - 1;
+    if (seconds > PROFILE_WINDOWS)
+        seconds = PROFILE_WINDOWS;
+    if (seconds == 0)
+    {
+        printfUart0("top: no data yet\n");
+        return;
+    }
+
+    newest = profileSnapshot[profileHead];
+    oldest = &profileSnapshot[(profileHead + PROFILE_WINDOWS + 1 - seconds) % (PROFILE_WINDOWS + 1)];
+    total = newest.time - oldest->time;
+
+    for (i = 0; i < PROFILE_SLOTS; i++)
+        busy += newest.cycles[i] - oldest->cycles[i];
+
+    printfUart0("top: last %u s   busy ", seconds);
+    printPercent(busy, total);
+    printfUart0("   idle ");
+    printPercent(total - busy, total);
+    printfUart0("\n");
+
+    for (i = 0; i < PROFILE_SLOTS; i++)
+    {
+        cycles = newest.cycles[i] - oldest->cycles[i];
+        if (profileName[i] == 0 || cycles == 0)
+            continue;
+        printfUart0("  %s   ", profileName[i]);
+        printPercent(cycles, total);
+        // A call that started before the window can put cycles in it without a call, divides trap
+        calls = newest.calls[i] - oldest->calls[i];
+        printfUart0("   calls/s %u   avg us %u\n", calls / seconds, calls ? cycles / TIMING_CYCLES_PER_US / calls : 0);
+    }
+}
@@ -0,0 +1,59 @@
+// CPU Profiler Library
+// Xavier
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    80 MHz
+
+// Hardware configuration:
+// Cortex-M4 DWT cycle counter
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef PROFILER_H_
+#define PROFILER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "scheduler.h"
+
+// General Defines
+#define PROFILE_WINDOWS         8     // one-second snapshots kept for top
+#define PROFILE_SNAPSHOT_MS     1000
+
+// Slots, the scheduler tasks take the first SCHEDULER_MAX_TASKS
+#define PROFILE_TICK            (SCHEDULER_MAX_TASKS + 0)   // SysTick minus the tasks it runs
+#define PROFILE_PENDSV          (SCHEDULER_MAX_TASKS + 1)   // PendSV minus the tasks it runs
+#define PROFILE_WHEEL_LEFT      (SCHEDULER_MAX_TASKS + 2)   // wideTimer1Isr
+#define PROFILE_WHEEL_RIGHT     (SCHEDULER_MAX_TASKS + 3)   // wideTimer5Isr
+#define PROFILE_IR              (SCHEDULER_MAX_TASKS + 4)   // wideTimer3Isr
+#define PROFILE_LOAD            (SCHEDULER_MAX_TASKS + 5)   // latencyLoadIsr
+#define PROFILE_MAIN            (SCHEDULER_MAX_TASKS + 6)   // main loop housekeeping
+#define PROFILE_CLI             (SCHEDULER_MAX_TASKS + 7)   // CLI command handling
+#define PROFILE_SLOTS           (SCHEDULER_MAX_TASKS + 8)
+
+// Structs
+typedef struct _PROFILE_MARK
+{
+    uint32_t start;     // CYCCNT on entry
+    uint32_t nested;    // profileNested on entry
+} PROFILE_MARK;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initProfiler(void);
+void registerProfileSlot(uint8_t slot, char* name);
+PROFILE_MARK profileEnter(void);
+void profileExit(uint8_t slot, PROFILE_MARK mark);
+void takeProfileSnapshot(void);
+void printProfile(uint8_t seconds);
+
+#endif
@@ -0,0 +1,228 @@
+// Scheduler Library
+// Xavier
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    80 MHz
+
+// Hardware configuration:
+// SysTick for the tick, PendSV for deferred tasks
+
+// Cooperative rate-group scheduler. The task table is a static array of
+// TASK entries (see main), adding a rate group is adding an entry.
+// Every SysTick each task's countdown is decremented, released tasks at
+// SCHEDULER_PRIORITY_TICK run immediately in the tick, the rest are marked
+// and PendSV runs them to completion in priority order. SysTick preempts
+// PendSV, so a long deferred task can't delay the tick tasks. The levels come
+// from priorities.h.
+// The tick also records how late it was entered, which is the worst-case
+// delay the balance task sees from every other interrupt.
+// A task released again before its previous release ran counts an overrun.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "tm4c123gh6pm.h"
+#include "scheduler.h"
+#include "timing.h"
+#include "profiler.h"
+#include "crash.h"
+#include "stackMonitor.h"
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+const TASK* tasks;
+uint8_t taskCount = 0;
+
+uint16_t taskCountdown[SCHEDULER_MAX_TASKS];
+volatile uint8_t taskReleased[SCHEDULER_MAX_TASKS];  // written by SysTick only
+volatile uint8_t taskHandled[SCHEDULER_MAX_TASKS];   // written by PendSV only
+uint32_t taskOverruns[SCHEDULER_MAX_TASKS];
+
+volatile uint32_t schedulerTicks = 0;
+volatile uint8_t activeTask = SCHEDULER_NONE;       // innermost task running, for the crash report
+
+TICK_LATENCY tickLatency;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initScheduler(const TASK* table, uint8_t count)
+{
+    uint8_t i;
+
+    tasks = table;
+    taskCount = (count < SCHEDULER_MAX_TASKS) ? count : SCHEDULER_MAX_TASKS;
+
+    initTiming();
+    initProfiler();
+    for (i = 0; i < taskCount; i++)
+    {
+        taskCountdown[i] = tasks[i].phase + 1;
+        taskReleased[i] = 0;
+        taskHandled[i] = 0;
+        taskOverruns[i] = 0;
+        registerTaskTiming(i, tasks[i].name, tasks[i].period * (TIMING_CYCLES_PER_US * 1000000 / SCHEDULER_TICK_HZ));
+        registerProfileSlot(i, tasks[i].name);
+    }
+    clearTickLatency();
+}
+
+void startScheduler(void)
+{
+    // SysTick above PendSV so tick tasks preempt deferred ones, set by initPriorities()
+    NVIC_ST_CTRL_R = 0;                              // turn-off SysTick before reconfiguring
+    NVIC_ST_RELOAD_R = (TIMING_CYCLES_PER_US * 1000000 / SCHEDULER_TICK_HZ) - 1; // 1 ms tick
+    NVIC_ST_CURRENT_R = 0;
+    NVIC_ST_CTRL_R = NVIC_ST_CTRL_CLK_SRC | NVIC_ST_CTRL_INTEN | NVIC_ST_CTRL_ENABLE; // system clock, interrupts on
+}
+
+// Releases stop, countdowns keep their place for startScheduler()
+void stopScheduler(void)
+{
+    NVIC_ST_CTRL_R = 0;
+}
+
+uint8_t getTaskCount(void)
+{
+    return taskCount;
+}
+
+const char* getTaskName(uint8_t task)
+{
+    return (task < taskCount) ? tasks[task].name : "?";
+}
+
+uint8_t getActiveTask(void)
+{
+    return activeTask;
+}
+
+uint32_t getTaskOverruns(uint8_t task)
+{
+    return taskOverruns[task];
+}
+
+void clearTaskOverruns(uint8_t task)
+{
+    taskOverruns[task] = 0;
+}
+
+uint32_t getSchedulerTicks(void)
+{
+    return schedulerTicks;
+}
+
+TICK_LATENCY getTickLatency(void)
+{
+    return tickLatency;
+}
+
+void clearTickLatency(void)
+{
+    uint8_t i;
+
+    tickLatency.samples = 0;
+    tickLatency.max = 0;
+    for (i = 0; i < TIMING_BUCKETS; i++)
+        tickLatency.histogram[i] = 0;
+}
+
+void runTask(uint8_t task)
+{
+    PROFILE_MARK mark = profileEnter();
+    uint8_t preempted = activeTask;     // a tick task can interrupt a PendSV task
+    activeTask = task;
+    traceEvent(TRACE_TASK, task);
+    startTaskTiming(task);
+    tasks[task].function();
+    endTaskTiming(task);
+    activeTask = preempted;
+    profileExit(task, mark);
+}
+
+void sysTickIsr(void)
+{
+    // Cycles since the counter reloaded, includes the 12 cycle exception entry
+    uint32_t latency = NVIC_ST_RELOAD_R - NVIC_ST_CURRENT_R;
+    PROFILE_MARK mark = profileEnter();
+    uint8_t i;
+    uint8_t bucket = 0;
+    bool deferred = false;
+
+    schedulerTicks++;
+    sampleTickStack();
+
+    tickLatency.samples++;
+    if (latency > tickLatency.max)
+        tickLatency.max = latency;
+    latency >>= 4;
+    while (latency != 0 && bucket < TIMING_BUCKETS - 1)
+    {
+        latency >>= 1;
+        bucket++;
+    }
+    tickLatency.histogram[bucket]++;
+
+    for (i = 0; i < taskCount; i++)
+    {
+        if (--taskCountdown[i] != 0)
+            continue;
+        taskCountdown[i] = tasks[i].period;
+
+        if (tasks[i].priority == SCHEDULER_PRIORITY_TICK)
+        {
+            runTask(i);
+        }
+        else
+        {
+            taskReleased[i]++;
+            deferred = true;
+        }
+    }
+
+    if (deferred)
+        NVIC_INT_CTRL_R = NVIC_INT_CTRL_PEND_SV;
+
+    profileExit(PROFILE_TICK, mark);
+}
+
+void pendSvIsr(void)
+{
+    uint8_t i;
+    uint8_t next;
+    uint8_t pending;
+    PROFILE_MARK mark = profileEnter();
+
+    do
+    {
+        next = SCHEDULER_NONE;
+        for (i = 0; i < taskCount; i++)
+        {
+            if ((taskReleased[i] != taskHandled[i]) && ((next == SCHEDULER_NONE) || (tasks[i].priority < tasks[next].priority)))
+                next = i;
+        }
+
+        if (next != SCHEDULER_NONE)
+        {
+            pending = taskReleased[next] - taskHandled[next];
+            if (pending > 1)
+                taskOverruns[next] += pending - 1;
+            taskHandled[next] += pending;
+            runTask(next);
+        }
+    }
+    while (next != SCHEDULER_NONE);
+
+    profileExit(PROFILE_PENDSV, mark);
+}
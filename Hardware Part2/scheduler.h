@@ -0,0 +1,67 @@
+// Scheduler Library
+// Xavier
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    80 MHz
+
+// Hardware configuration:
+// SysTick for the tick, PendSV for deferred tasks
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef SCHEDULER_H_
+#define SCHEDULER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "timing.h"
+
+// General Defines
+#define SCHEDULER_TICK_HZ       1000
+#define SCHEDULER_MAX_TASKS     8
+#define SCHEDULER_PRIORITY_TICK 0     // runs inside the SysTick ISR, everything else runs from PendSV
+#define SCHEDULER_NONE          0xFF  // no task
+
+// Structs
+typedef struct _TASK
+{
+    char* name;
+    void (*function)(void);
+    uint16_t period;    // ticks between releases
+    uint16_t phase;     // ticks before the first release, spreads tasks across ticks
+    uint8_t priority;   // lower runs first, SCHEDULER_PRIORITY_TICK runs in the tick itself
+} TASK;
+
+typedef struct _TICK_LATENCY
+{
+    uint32_t samples;
+    uint32_t max;                          // cycles from the tick to the first instruction of the ISR
+    uint32_t histogram[TIMING_BUCKETS];    // <16, <32, <64 ... >=1024 cycles
+} TICK_LATENCY;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initScheduler(const TASK* table, uint8_t count);
+void startScheduler(void);
+void stopScheduler(void);
+uint8_t getTaskCount(void);
+const char* getTaskName(uint8_t task);
+uint8_t getActiveTask(void);
+uint32_t getTaskOverruns(uint8_t task);
+void clearTaskOverruns(uint8_t task);
+uint32_t getSchedulerTicks(void);
+TICK_LATENCY getTickLatency(void);
+void clearTickLatency(void);
+void sysTickIsr(void);
+void pendSvIsr(void);
+
+#endif
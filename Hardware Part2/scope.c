@@ -0,0 +1,472 @@
+// Scope Library
+// Xavier
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    80 MHz
+
+// Hardware configuration:
+// UART Interface:
+//   U0TX (PA1) shared with the CLI
+
+// Oscilloscope for firmware variables. The application registers variables
+// by name and address once, `scope add` picks up to SCOPE_MAX_CHANNELS of
+// them. sampleScope() runs in the balance tick and copies one 32-bit word
+// per channel into a ring in RAM every nth tick, nothing is formatted or
+// sent then, so capturing costs a few loads and stores per tick.
+// Armed, the ring keeps the last `pre` samples. The trigger fires on the
+// tick its condition becomes true (value > level, < level or |value| >
+// level), an edge, so a robot already lying down doesn't trigger it at
+// once. `post` more samples are taken and the capture is frozen.
+// The capture then goes out as telemetry packets (telemetry.c framing):
+//   TELEMETRY_PACKET_SCOPE_HEADER: capture (1), channels (1), decimation (1),
+//     tick us (4), pre (2), post (2), trigger condition (1), level f (4),
+//     trigger name (8), then per channel type (1) and name (8)
+//   TELEMETRY_PACKET_SCOPE_DATA: capture (1), first sample (2), samples (1),
+//     then the samples, one word per channel, oldest first
+// The main loop sends what fits in the UART ring and goes back to sleep,
+// the UART0 low-water hook brings it back when half the ring has drained,
+// so the dump never blocks or busy-polls. tools/telemetry_decode.py writes
+// it out with the time of every sample relative to the trigger.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include "scope.h"
+#include "telemetry.h"
+#include "events.h"
+#include "uart0.h"
+
+#define SCOPE_WORDS_PER_PACKET ((TELEMETRY_MAX_PACKET - 7 - 4) / 4)
+#define SCOPE_RESUME_QUEUED    (UART0_TX_BUFFER_SIZE / 2)   // a dump waiting for room goes on once the ring is down to this
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+SCOPE_VARIABLE scopeVariables[SCOPE_MAX_VARIABLES];
+uint8_t scopeVariableCount = 0;
+uint8_t scopeChannels[SCOPE_MAX_CHANNELS];  // index into scopeVariables
+uint8_t scopeChannelCount = 0;
+
+uint32_t scopeBuffer[SCOPE_BUFFER_WORDS];   // ring of samples, scopeChannelCount words each
+uint32_t scopeTickUs = 0;
+uint8_t scopeDecimation = 1;
+uint8_t scopeCountdown = 1;
+uint16_t scopePre = 0;
+uint16_t scopePost = 0;
+uint16_t scopeDepth = 0;
+
+volatile ScopeState scopeState = SCOPE_IDLE;
+uint16_t scopeWrite = 0;                    // next sample in the ring
+uint16_t scopeFilled = 0;                   // samples since arming, up to scopeDepth
+uint16_t scopePostLeft = 0;
+uint16_t scopeTriggerSample = 0;            // ring index of the trigger sample
+volatile bool scopeForce = false;
+uint8_t scopeCaptures = 0;                  // ties data packets to their header
+
+uint8_t triggerVariable = SCOPE_NONE;
+ScopeCondition triggerCondition = SCOPE_OUTSIDE;
+float triggerLevel = 0;
+bool triggerWasTrue = true;
+
+bool scopeDumping = false;
+int32_t scopeDumpNext = 0;                  // next sample to send, -1 for the header
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// tickUs is how often sampleScope() is called
+void initScope(uint32_t tickUs)
+{
+    scopeTickUs = tickUs;
+    scopeVariableCount = 0;
+    scopeChannelCount = 0;
+    scopeDecimation = 1;
+    scopePre = 0;
+    scopePost = 0;
+    scopeDepth = 0;
+    triggerVariable = SCOPE_NONE;
+    scopeState = SCOPE_IDLE;
+    scopeDumping = false;
+}
+
+bool registerScopeVariable(const char* name, const volatile void* address, ScopeType type)
+{
+    if (scopeVariableCount >= SCOPE_MAX_VARIABLES)
+        return false;
+    scopeVariables[scopeVariableCount].name = name;
+    scopeVariables[scopeVariableCount].address = address;
+    scopeVariables[scopeVariableCount].type = type;
+    scopeVariableCount++;
+    return true;
+}
+
+uint8_t findScopeVariable(const char* name)
+{
+    uint8_t i;
+
+    for (i = 0; i < scopeVariableCount; i++)
+    {
+        if (customStrcmp(scopeVariables[i].name, name))
+            return i;
+    }
+    return SCOPE_NONE;
+}
+
+// Settings can't change under a running capture, a finished one is dropped
+bool canConfigureScope(void)
+{
+    if (scopeState == SCOPE_ARMED || scopeState == SCOPE_TRIGGERED)
+        return false;
+    scopeState = SCOPE_IDLE;
+    scopeDumping = false;
+    return true;
+}
+
+bool addScopeChannel(const char* name)
+{
+    uint8_t variable = findScopeVariable(name);
+
+    if (variable == SCOPE_NONE || scopeChannelCount >= SCOPE_MAX_CHANNELS || !canConfigureScope())
+        return false;
+    scopeChannels[scopeChannelCount++] = variable;
+    scopeDepth = SCOPE_BUFFER_WORDS / scopeChannelCount;
+    return true;
+}
+
+bool clearScopeChannels(void)
+{
+    if (!canConfigureScope())
+        return false;
+    scopeChannelCount = 0;
+    scopeDepth = 0;
+    return true;
+}
+
+// A sample every nth tick, 0 is taken as 1
+bool setScopeDecimation(uint8_t decimation)
+{
+    if (!canConfigureScope())
+        return false;
+    scopeDecimation = (decimation == 0) ? 1 : decimation;
+    return true;
+}
+
+// Samples kept before the trigger sample and taken after it
+bool setScopeWindow(uint16_t pre, uint16_t post)
+{
+    if (!canConfigureScope())
+        return false;
+    scopePre = pre;
+    scopePost = post;
+    return true;
+}
+
+bool setScopeTrigger(const char* name, ScopeCondition condition, float level)
+{
+    uint8_t variable = findScopeVariable(name);
+
+    if (variable == SCOPE_NONE || !canConfigureScope())
+        return false;
+    triggerVariable = variable;
+    triggerCondition = condition;
+    triggerLevel = level;
+    return true;
+}
+
+// Triggers as soon as the pre window is full
+bool clearScopeTrigger(void)
+{
+    if (!canConfigureScope())
+        return false;
+    triggerVariable = SCOPE_NONE;
+    return true;
+}
+
+// Returns false if no channels are set or the window doesn't fit the buffer
+bool armScope(void)
+{
+    if (scopeChannelCount == 0 || (uint32_t)scopePre + 1 + scopePost > scopeDepth)
+        return false;
+    if (scopeState == SCOPE_ARMED || scopeState == SCOPE_TRIGGERED)
+        scopeState = SCOPE_IDLE;
+    scopeWrite = 0;
+    scopeFilled = 0;
+    scopeCountdown = 1;
+    scopeForce = false;
+    triggerWasTrue = true;
+    scopeDumping = false;
+    scopeState = SCOPE_ARMED;           // last, sampleScope() may run right after
+    return true;
+}
+
+// Triggers on the next sample once the pre window is full
+void forceScopeTrigger(void)
+{
+    scopeForce = true;
+}
+
+void stopScope(void)
+{
+    if (scopeState == SCOPE_ARMED || scopeState == SCOPE_TRIGGERED)
+        scopeState = SCOPE_IDLE;
+    scopeDumping = false;
+}
+
+uint32_t readScopeWord(const SCOPE_VARIABLE* variable)
+{
+    switch (variable->type)
+    {
+        case SCOPE_INT16:
+            return (int32_t)*(const volatile int16_t*)variable->address;
+        case SCOPE_UINT16:
+            return *(const volatile uint16_t*)variable->address;
+        default:
+            return *(const volatile uint32_t*)variable->address;
+    }
+}
+
+float readScopeValue(const SCOPE_VARIABLE* variable)
+{
+    switch (variable->type)
+    {
+        case SCOPE_FLOAT:
+            return *(const volatile float*)variable->address;
+        case SCOPE_INT32:
+            return *(const volatile int32_t*)variable->address;
+        case SCOPE_INT16:
+            return *(const volatile int16_t*)variable->address;
+        default:
+            return *(const volatile uint16_t*)variable->address;
+    }
+}
+
+// True on the sample the condition becomes true
+bool isScopeTriggered(void)
+{
+    float value;
+    bool now;
+    bool edge;
+
+    if (triggerVariable == SCOPE_NONE)
+        return true;
+
+    value = readScopeValue(&scopeVariables[triggerVariable]);
+    switch (triggerCondition)
+    {
+        case SCOPE_ABOVE:
+            now = value > triggerLevel;
+        break;
+        case SCOPE_BELOW:
+            now = value < triggerLevel;
+        break;
+        default:
+            now = fabs(value) > triggerLevel;
+        break;
+    }
+    edge = now && !triggerWasTrue;
+    triggerWasTrue = now;
+    return edge;
+}
+
+// Balance tick, posts EVENT_SCOPE_DUMP when a capture is complete
+void sampleScope(void)
+{
+    uint32_t* sample;
+    bool triggered;
+    uint8_t i;
+
+    if (scopeState != SCOPE_ARMED && scopeState != SCOPE_TRIGGERED)
+        return;
+    if (--scopeCountdown != 0)
+        return;
+    scopeCountdown = scopeDecimation;
+
+    sample = &scopeBuffer[scopeWrite * scopeChannelCount];
+    for (i = 0; i < scopeChannelCount; i++)
+        sample[i] = readScopeWord(&scopeVariables[scopeChannels[i]]);
+    if (scopeFilled < scopeDepth)
+        scopeFilled++;
+
+    if (scopeState == SCOPE_ARMED)
+    {
+        // The edge is tracked while the pre window fills too
+        triggered = isScopeTriggered() || scopeForce;
+        if (triggered && scopeFilled > scopePre)
+        {
+            scopeTriggerSample = scopeWrite;
+            scopePostLeft = scopePost;
+            scopeState = SCOPE_TRIGGERED;
+        }
+    }
+    else
+    {
+        scopePostLeft--;
+    }
+
+    scopeWrite = (scopeWrite + 1 == scopeDepth) ? 0 : scopeWrite + 1;
+
+    if (scopeState == SCOPE_TRIGGERED && scopePostLeft == 0)
+    {
+        scopeState = SCOPE_CAPTURED;
+        scopeCaptures++;
+        startScopeDump();
+        postEvent(EVENT_SCOPE_DUMP, scopeCaptures);
+    }
+}
+
+// Sends the frozen capture (again), false if there is none
+bool startScopeDump(void)
+{
+    if (scopeState != SCOPE_CAPTURED)
+        return false;
+    scopeDumpNext = -1;
+    scopeDumping = true;
+    return true;
+}
+
+void putScopeName(uint8_t* p, const char* name)
+{
+    uint8_t i;
+
+    for (i = 0; i < SCOPE_NAME_LENGTH; i++)
+        p[i] = 0;
+    for (i = 0; (i < SCOPE_NAME_LENGTH) && (name[i] != '\0'); i++)
+        p[i] = name[i];
+}
+
+uint16_t buildScopeHeader(uint8_t* packet)
+{
+    uint16_t length = startPacket(packet, TELEMETRY_PACKET_SCOPE_HEADER);
+    uint8_t i;
+
+    packet[length++] = scopeCaptures;
+    packet[length++] = scopeChannelCount;
+    packet[length++] = scopeDecimation;
+    putU32(&packet[length], scopeTickUs);
+    putU16(&packet[length + 4], scopePre);
+    putU16(&packet[length + 6], scopePost);
+    packet[length + 8] = (triggerVariable == SCOPE_NONE) ? SCOPE_NONE : triggerCondition;
+    putF32(&packet[length + 9], triggerLevel);
+    putScopeName(&packet[length + 13], (triggerVariable == SCOPE_NONE) ? "" : scopeVariables[triggerVariable].name);
+    length += 13 + SCOPE_NAME_LENGTH;
+    for (i = 0; i < scopeChannelCount; i++)
+    {
+        packet[length++] = scopeVariables[scopeChannels[i]].type;
+        putScopeName(&packet[length], scopeVariables[scopeChannels[i]].name);
+        length += SCOPE_NAME_LENGTH;
+    }
+    return length;
+}
+
+// Samples from first (0 = oldest of the capture) on, as many as fit
+uint16_t buildScopeData(uint8_t* packet, uint16_t first, uint8_t* count)
+{
+    uint16_t length = startPacket(packet, TELEMETRY_PACKET_SCOPE_DATA);
+    uint16_t total = scopePre + 1 + scopePost;
+    uint16_t ring = (scopeTriggerSample + scopeDepth - scopePre + first) % scopeDepth;
+    uint8_t perPacket = SCOPE_WORDS_PER_PACKET / scopeChannelCount;
+    uint8_t i, j;
+
+    *count = (total - first < perPacket) ? total - first : perPacket;
+    packet[length++] = scopeCaptures;
+    putU16(&packet[length], first);
+    packet[length + 2] = *count;
+    length += 3;
+    for (i = 0; i < *count; i++)
+    {
+        for (j = 0; j < scopeChannelCount; j++, length += 4)
+            putU32(&packet[length], scopeBuffer[ring * scopeChannelCount + j]);
+        ring = (ring + 1 == scopeDepth) ? 0 : ring + 1;
+    }
+    return length;
+}
+
+// Main loop, queues what fits in the UART ring
+// Returns true once the whole capture has been sent, false when the ring is
+// full, the UART0 low hook is armed then and the application calls again from it
+bool sendScopeDump(void)
+{
+    uint8_t packet[TELEMETRY_MAX_PACKET + 2];
+    uint16_t length;
+    uint8_t count = 0;
+
+    while (scopeDumping)
+    {
+        if (UART0_TX_BUFFER_SIZE - getUart0TxQueued() < TELEMETRY_MAX_FRAME)
+        {
+            if (armUart0TxLow(SCOPE_RESUME_QUEUED))
+                return false;
+            continue;                   // drained while we looked
+        }
+        if (scopeDumpNext < 0)
+            length = buildScopeHeader(packet);
+        else
+            length = buildScopeData(packet, scopeDumpNext, &count);
+        if (!finishPacket(packet, length))
+        {
+            // A telemetry sample took the room
+            if (armUart0TxLow(SCOPE_RESUME_QUEUED))
+                return false;
+            continue;
+        }
+        scopeDumpNext = (scopeDumpNext < 0) ? 0 : scopeDumpNext + count;
+        if (scopeDumpNext >= scopePre + 1 + scopePost)
+        {
+            scopeDumping = false;
+            printfUart0("Scope capture %u sent\n", scopeCaptures);
+        }
+    }
+    return true;
+}
+
+SCOPE_STATUS getScopeStatus(void)
+{
+    SCOPE_STATUS status;
+
+    status.state = scopeState;
+    status.channels = scopeChannelCount;
+    status.decimation = scopeDecimation;
+    status.pre = scopePre;
+    status.post = scopePost;
+    status.depth = scopeDepth;
+    status.filled = scopeFilled;
+    status.captures = scopeCaptures;
+    status.dumping = scopeDumping;
+    return status;
+}
+
+void printScopeStatus(void)
+{
+    const char* stateNames[] = { "idle", "armed", "triggered", "captured" };
+    uint32_t sampleUs = scopeTickUs * scopeDecimation;
+    uint8_t i;
+
+    printfUart0("scope %s%s   %u captures\n", stateNames[scopeState], scopeDumping ? ", sending" : "", scopeCaptures);
+    printfUart0("  channels:");
+    for (i = 0; i < scopeChannelCount; i++)
+        printfUart0(" %s", scopeVariables[scopeChannels[i]].name);
+    printfUart0("\n  a sample every %u ticks (%u ms), %u before and %u after the trigger, %u fit\n",
+                scopeDecimation, sampleUs / 1000, scopePre, scopePost, scopeDepth);
+    if (triggerVariable == SCOPE_NONE)
+        printfUart0("  trigger: none, starts when the pre window is full\n");
+    else if (triggerCondition == SCOPE_OUTSIDE)
+        printfUart0("  trigger: |%s| > %.2f\n", scopeVariables[triggerVariable].name, triggerLevel);
+    else
+        printfUart0("  trigger: %s %c %.2f\n", scopeVariables[triggerVariable].name,
+                    (triggerCondition == SCOPE_ABOVE) ? '>' : '<', triggerLevel);
+    printfUart0("  variables:");
+    for (i = 0; i < scopeVariableCount; i++)
+        printfUart0(" %s", scopeVariables[i].name);
+    printfUart0("\n");
+}
@@ -0,0 +1,98 @@
+// Scope Library
+// Xavier
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    80 MHz
+
+// Hardware configuration:
+// UART Interface:
+//   U0TX (PA1) shared with the CLI
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef SCOPE_H_
+#define SCOPE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// General Defines
+#define SCOPE_MAX_VARIABLES  24
+#define SCOPE_MAX_CHANNELS   8       // variables captured at once
+#define SCOPE_BUFFER_WORDS   1024    // 4 KB, samples = words / channels
+#define SCOPE_NAME_LENGTH    8
+#define SCOPE_NONE           0xFF    // no trigger variable, triggers as soon as the pre window is full
+
+// Structs
+typedef enum
+{
+    SCOPE_FLOAT,
+    SCOPE_INT32,
+    SCOPE_INT16,            // captured sign extended to 32 bits
+    SCOPE_UINT16            // captured zero extended to 32 bits
+} ScopeType;
+
+typedef enum
+{
+    SCOPE_ABOVE,            // value > level
+    SCOPE_BELOW,            // value < level
+    SCOPE_OUTSIDE           // |value| > level
+} ScopeCondition;
+
+typedef enum
+{
+    SCOPE_IDLE,
+    SCOPE_ARMED,            // filling the pre window, then waiting for the trigger
+    SCOPE_TRIGGERED,        // filling the post window
+    SCOPE_CAPTURED          // buffer holds a capture, being or done being dumped
+} ScopeState;
+
+typedef struct _SCOPE_VARIABLE
+{
+    const char* name;
+    const volatile void* address;
+    ScopeType type;
+} SCOPE_VARIABLE;
+
+typedef struct _SCOPE_STATUS
+{
+    ScopeState state;
+    uint8_t channels;
+    uint8_t decimation;
+    uint16_t pre;
+    uint16_t post;
+    uint16_t depth;         // samples the buffer holds with these channels
+    uint16_t filled;
+    uint8_t captures;
+    bool dumping;
+} SCOPE_STATUS;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initScope(uint32_t tickUs);
+bool registerScopeVariable(const char* name, const volatile void* address, ScopeType type);
+bool addScopeChannel(const char* name);
+bool clearScopeChannels(void);
+bool setScopeDecimation(uint8_t decimation);
+bool setScopeWindow(uint16_t pre, uint16_t post);
+bool setScopeTrigger(const char* name, ScopeCondition condition, float level);
+bool clearScopeTrigger(void);
+bool armScope(void);
+void forceScopeTrigger(void);
+void stopScope(void);
+void sampleScope(void);
+bool startScopeDump(void);
+bool sendScopeDump(void);
+SCOPE_STATUS getScopeStatus(void);
+void printScopeStatus(void);
+
+#endif
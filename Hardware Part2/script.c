@@ -0,0 +1,454 @@
+// Script Library
+// Xavier
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    80 MHz
+
+// Hardware configuration: -
+
+// A script is a list of moves run one after the other without the CLI:
+//   forward [distance]        reverse [distance]      (m, or cm with a unit)
+//   rotate cw|ccw [deg]       wait <ms>               settle
+//   repeat <n> ... end        loop ... end            abort <deg>
+// `script load` sends the lines that follow here instead of to the command
+// table, `done` ends the upload. Each line is checked and turned into a step
+// as it arrives, so a bad line is reported with its number and a script that
+// loaded runs to the end without surprises.
+// stepScript() advances the script from the motion task every 10 ms. A move
+// is started on one tick and polled on the next ones, nothing here waits, so
+// the main loop and the control loops keep running. `settle` waits until the
+// move is over and the tilt has stayed inside SCRIPT_SETTLE_DEG for
+// SCRIPT_SETTLE_MS, and `abort <deg>` stops the script and the motors as soon
+// as the tilt goes past <deg>.
+// The script stays in RAM until the next load, `script run` runs it again.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include "script.h"
+#include "uart0.h"
+#include "timebase.h"
+#include "events.h"
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+const SCRIPT_MOTION* scriptHooks = 0;
+
+SCRIPT_STEP scriptSteps[SCRIPT_MAX_STEPS];
+uint8_t scriptStepCount = 0;
+volatile ScriptState scriptState = SCRIPT_IDLE;
+
+// Upload
+uint8_t loadStack[SCRIPT_MAX_DEPTH];    // open repeat/loop steps
+uint8_t loadDepth = 0;
+uint16_t loadLine = 0;
+bool loadFailed = false;
+
+// Run, only touched by stepScript() while the script runs
+uint8_t scriptPc = 0;
+bool stepStarted = false;
+DEADLINE stepDeadline;                  // end of a wait, settle timeout
+DEADLINE settleBy;                      // settled if the tilt stays in until then
+uint16_t repeatsLeft[SCRIPT_MAX_STEPS]; // by repeat step
+float abortTilt = 0;
+float lastTilt = 0;
+uint32_t scriptRuns = 0;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initScript(const SCRIPT_MOTION* motion)
+{
+    scriptHooks = motion;
+    scriptStepCount = 0;
+    scriptState = SCRIPT_IDLE;
+}
+
+// Drops the stored script, addScriptLine() gets the lines from here on
+void beginScriptLoad(void)
+{
+    scriptStepCount = 0;
+    loadDepth = 0;
+    loadLine = 0;
+    loadFailed = false;
+    scriptState = SCRIPT_LOADING;
+}
+
+bool isScriptLoading(void)
+{
+    return scriptState == SCRIPT_LOADING;
+}
+
+bool loadError(const char* message)
+{
+    printfUart0("script line %u: %s\n", loadLine, message);
+    loadFailed = true;
+    return false;
+}
+
+bool addStep(uint8_t op, float value)
+{
+    if (scriptStepCount >= SCRIPT_MAX_STEPS)
+        return loadError("too many steps");
+    scriptSteps[scriptStepCount].op = op;
+    scriptSteps[scriptStepCount].jump = 0;
+    scriptSteps[scriptStepCount].value = value;
+    scriptStepCount++;
+    return true;
+}
+
+// Number in field 1 if there is one, or the default
+bool getStepNumber(USER_DATA* data, uint8_t field, float fallback, float* value)
+{
+    if (data->fieldCount <= field)
+    {
+        *value = fallback;
+        return true;
+    }
+    if (data->fieldType[field] == 'a')
+        return false;
+    *value = getFieldNumber(data, field);
+    return true;
+}
+
+bool addDriveStep(USER_DATA* data, float sign)
+{
+    float meters;
+
+    if (data->fieldCount > 2 || !getStepNumber(data, 1, 1.0, &meters))
+        return loadError("usage: forward|reverse [distance, m or cm]");
+    if (data->fieldCount > 1 && getFieldUnit(data, 1) == UNIT_CM)
+        meters /= 100;
+    else if (data->fieldCount > 1 && getFieldUnit(data, 1) != UNIT_NONE && getFieldUnit(data, 1) != UNIT_M)
+        return loadError("distance should be in m or cm");
+    if (meters == 0 || meters > SCRIPT_MAX_M || meters < -SCRIPT_MAX_M)
+        return loadError("distance out of range");
+    return addStep(SCRIPT_DRIVE, sign * meters);
+}
+
+bool addRotateStep(USER_DATA* data)
+{
+    char* direction;
+    float degrees;
+
+    if (data->fieldCount < 2 || data->fieldCount > 3 || !getStepNumber(data, 2, 90, &degrees)
+        || (data->fieldCount > 2 && getFieldUnit(data, 2) != UNIT_NONE && getFieldUnit(data, 2) != UNIT_DEG))
+        return loadError("usage: rotate cw|ccw [deg]");
+    direction = getFieldString(data, 1);
+    if (customStrcmp("ccw", direction))
+        degrees = -degrees;
+    else if (!customStrcmp("cw", direction))
+        return loadError("usage: rotate cw|ccw [deg]");
+    degrees = (int16_t)degrees;
+    if (degrees == 0 || degrees > SCRIPT_MAX_DEG || degrees < -SCRIPT_MAX_DEG)
+        return loadError("angle out of range");
+    return addStep(SCRIPT_ROTATE, degrees);
+}
+
+// Only an integer with no unit
+bool getStepCount(USER_DATA* data, uint32_t max, float* value)
+{
+    if (data->fieldCount != 2 || data->fieldType[1] != 'n' || getFieldUnit(data, 1) != UNIT_NONE)
+        return false;
+    *value = getFieldInteger(data, 1);
+    return *value >= 0 && *value <= max;
+}
+
+bool openBlock(float count)
+{
+    if (loadDepth >= SCRIPT_MAX_DEPTH)
+        return loadError("repeat and loop nest too deep");
+    if (!addStep(SCRIPT_REPEAT, count))
+        return false;
+    loadStack[loadDepth++] = scriptStepCount - 1;
+    return true;
+}
+
+bool closeBlock(void)
+{
+    uint8_t repeat;
+
+    if (loadDepth == 0)
+        return loadError("end without repeat or loop");
+    repeat = loadStack[loadDepth - 1];
+    if (repeat == scriptStepCount - 1)
+        return loadError("empty repeat or loop");
+    if (!addStep(SCRIPT_END, 0))
+        return false;
+    loadDepth--;
+    scriptSteps[scriptStepCount - 1].jump = repeat;
+    scriptSteps[repeat].jump = scriptStepCount - 1;
+    return true;
+}
+
+// Ends the upload, the script is kept only if every line loaded
+void finishScriptLoad(void)
+{
+    if (loadDepth != 0)
+        loadError("repeat or loop without end");
+    if (loadFailed || scriptStepCount == 0)
+    {
+        scriptStepCount = 0;
+        scriptState = SCRIPT_IDLE;
+        printfUart0("script not loaded\n");
+        return;
+    }
+    scriptState = SCRIPT_IDLE;
+    printfUart0("script loaded, %u steps\n", scriptStepCount);
+}
+
+// One uploaded line, already split by parseFields()
+// Returns false after printing why if the line is not a step
+bool addScriptLine(USER_DATA* data)
+{
+    char* op;
+    float value;
+
+    if (data->fieldCount == 0)
+        return true;
+
+    loadLine++;
+    op = getFieldString(data, 0);
+    if (customStrcmp("done", op))
+    {
+        finishScriptLoad();
+        return true;
+    }
+    if (customStrcmp("forward", op))
+        return addDriveStep(data, 1);
+    if (customStrcmp("reverse", op))
+        return addDriveStep(data, -1);
+    if (customStrcmp("rotate", op))
+        return addRotateStep(data);
+    if (customStrcmp("wait", op))
+    {
+        if (!getStepCount(data, SCRIPT_MAX_WAIT_MS, &value) || value == 0)
+            return loadError("usage: wait <ms>");
+        return addStep(SCRIPT_WAIT, value);
+    }
+    if (customStrcmp("settle", op) && data->fieldCount == 1)
+        return addStep(SCRIPT_SETTLE, 0);
+    if (customStrcmp("repeat", op))
+    {
+        if (!getStepCount(data, UINT16_MAX, &value) || value == 0)
+            return loadError("usage: repeat <n>");
+        return openBlock(value);
+    }
+    if (customStrcmp("loop", op) && data->fieldCount == 1)
+        return openBlock(0);
+    if (customStrcmp("end", op) && data->fieldCount == 1)
+        return closeBlock();
+    if (customStrcmp("abort", op))
+    {
+        if (data->fieldCount != 2 || !getStepNumber(data, 1, 0, &value) || value < 0
+            || (getFieldUnit(data, 1) != UNIT_NONE && getFieldUnit(data, 1) != UNIT_DEG))
+            return loadError("usage: abort <deg>, 0 for off");
+        return addStep(SCRIPT_ABORT_TILT, value);
+    }
+    return loadError("unknown step");
+}
+
+// Returns false if there is nothing to run or it is already running
+bool startScript(void)
+{
+    if (scriptStepCount == 0 || scriptState == SCRIPT_RUNNING || scriptState == SCRIPT_LOADING)
+        return false;
+    scriptPc = 0;
+    stepStarted = false;
+    abortTilt = 0;
+    scriptRuns++;
+    scriptState = SCRIPT_RUNNING;           // last, stepScript() may run right after
+    return true;
+}
+
+// The state changes first so the motion task leaves the motors alone
+void endScript(ScriptState state)
+{
+    scriptState = state;
+    if (state != SCRIPT_DONE)
+        scriptHooks->stop();
+}
+
+// From the CLI or a button, stops the motors if a script was running
+void stopScript(void)
+{
+    if (scriptState == SCRIPT_RUNNING)
+        endScript(SCRIPT_STOPPED);
+}
+
+bool isScriptRunning(void)
+{
+    return scriptState == SCRIPT_RUNNING;
+}
+
+// Motion task, 100 Hz
+// Runs steps until one has to wait, posts EVENT_SCRIPT_END when the script ends
+void stepScript(void)
+{
+    SCRIPT_STEP* step;
+    uint8_t executed;
+    uint8_t repeat;
+
+    if (scriptState != SCRIPT_RUNNING)
+        return;
+
+    lastTilt = scriptHooks->getTilt();
+    if (abortTilt > 0 && fabs(lastTilt) > abortTilt)
+    {
+        endScript(SCRIPT_ABORTED_TILT);
+        postEvent(EVENT_SCRIPT_END, SCRIPT_ABORTED_TILT);
+        return;
+    }
+
+    // A loop of steps that never wait gets one pass per tick
+    for (executed = 0; executed < SCRIPT_MAX_STEPS; executed++)
+    {
+        if (scriptPc >= scriptStepCount)
+        {
+            endScript(SCRIPT_DONE);
+            postEvent(EVENT_SCRIPT_END, SCRIPT_DONE);
+            return;
+        }
+
+        step = &scriptSteps[scriptPc];
+        switch (step->op)
+        {
+            case SCRIPT_DRIVE:
+            case SCRIPT_ROTATE:
+                if (!stepStarted)
+                {
+                    if (step->op == SCRIPT_DRIVE)
+                        scriptHooks->drive(step->value);
+                    else
+                        scriptHooks->rotate(step->value);
+                    stepStarted = true;
+                    return;
+                }
+                if (scriptHooks->isMoving())
+                    return;
+            break;
+
+            case SCRIPT_WAIT:
+                if (!stepStarted)
+                {
+                    stepDeadline = deadlineIn(step->value * 1000);
+                    stepStarted = true;
+                }
+                if (!deadlinePassed(stepDeadline))
+                    return;
+            break;
+
+            case SCRIPT_SETTLE:
+                if (!stepStarted)
+                {
+                    stepDeadline = deadlineIn(SCRIPT_SETTLE_TIMEOUT_MS * 1000);
+                    settleBy = deadlineIn(SCRIPT_SETTLE_MS * 1000);
+                    stepStarted = true;
+                }
+                if (scriptHooks->isMoving() || fabs(lastTilt) > SCRIPT_SETTLE_DEG)
+                    settleBy = deadlineIn(SCRIPT_SETTLE_MS * 1000);
+                if (!deadlinePassed(settleBy))
+                {
+                    if (deadlinePassed(stepDeadline))
+                    {
+                        endScript(SCRIPT_ABORTED_SETTLE);
+                        postEvent(EVENT_SCRIPT_END, SCRIPT_ABORTED_SETTLE);
+                    }
+                    return;
+                }
+            break;
+
+            case SCRIPT_REPEAT:
+                repeatsLeft[scriptPc] = step->value;
+            break;
+
+            case SCRIPT_END:
+                repeat = step->jump;
+                if (scriptSteps[repeat].value == 0 || --repeatsLeft[repeat] > 0)
+                {
+                    scriptPc = repeat + 1;
+                    stepStarted = false;
+                    continue;
+                }
+            break;
+
+            case SCRIPT_ABORT_TILT:
+                abortTilt = step->value;
+            break;
+        }
+
+        scriptPc++;
+        stepStarted = false;
+    }
+}
+
+SCRIPT_STATUS getScriptStatus(void)
+{
+    SCRIPT_STATUS status;
+
+    status.state = scriptState;
+    status.steps = scriptStepCount;
+    status.step = scriptPc;
+    status.runs = scriptRuns;
+    status.abortTilt = abortTilt;
+    status.lastTilt = lastTilt;
+    return status;
+}
+
+// Listing of the stored script, loops indented
+void printScript(void)
+{
+    SCRIPT_STEP* step;
+    uint8_t depth = 0;
+    uint8_t i;
+
+    if (scriptState == SCRIPT_LOADING)
+        return;
+    for (i = 0; i < scriptStepCount; i++)
+    {
+        step = &scriptSteps[i];
+        if (step->op == SCRIPT_END)
+            depth--;
+        printfUart0("%c%2u %*s", (scriptState == SCRIPT_RUNNING && i == scriptPc) ? '>' : ' ', i, depth * 2, "");
+        switch (step->op)
+        {
+            case SCRIPT_DRIVE:
+                printfUart0("%s %.2f m\n", (step->value > 0) ? "forward" : "reverse", fabs(step->value));
+            break;
+            case SCRIPT_ROTATE:
+                printfUart0("rotate %s %.0f\n", (step->value > 0) ? "cw" : "ccw", fabs(step->value));
+            break;
+            case SCRIPT_WAIT:
+                printfUart0("wait %.0f\n", step->value);
+            break;
+            case SCRIPT_SETTLE:
+                printfUart0("settle\n");
+            break;
+            case SCRIPT_REPEAT:
+                if (step->value == 0)
+                    printfUart0("loop\n");
+                else
+                    printfUart0("repeat %.0f\n", step->value);
+                depth++;
+            break;
+            case SCRIPT_END:
+                printfUart0("end\n");
+            break;
+            case SCRIPT_ABORT_TILT:
+                printfUart0("abort %.1f\n", step->value);
+            break;
+        }
+    }
+}
@@ -0,0 +1,100 @@
+// Script Library
+// Xavier
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    80 MHz
+
+// Hardware configuration: -
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef SCRIPT_H_
+#define SCRIPT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "uart0.h"
+
+// General Defines
+#define SCRIPT_MAX_STEPS     32
+#define SCRIPT_MAX_DEPTH     4       // nested repeat/loop blocks
+#define SCRIPT_MAX_WAIT_MS   60000
+#define SCRIPT_MAX_M         10.0
+#define SCRIPT_MAX_DEG       180
+#define SCRIPT_SETTLE_DEG    5.0     // tilt has to stay inside this ...
+#define SCRIPT_SETTLE_MS     500     // ... for this long to count as settled
+#define SCRIPT_SETTLE_TIMEOUT_MS 5000
+
+// Structs
+typedef enum
+{
+    SCRIPT_DRIVE,           // value = m, negative is reverse
+    SCRIPT_ROTATE,          // value = deg, negative is ccw
+    SCRIPT_WAIT,            // value = ms
+    SCRIPT_SETTLE,
+    SCRIPT_REPEAT,          // value = count, 0 loops until stopped
+    SCRIPT_END,             // jump = the repeat it closes
+    SCRIPT_ABORT_TILT       // value = deg, 0 turns the check off
+} ScriptOp;
+
+typedef enum
+{
+    SCRIPT_IDLE,
+    SCRIPT_LOADING,
+    SCRIPT_RUNNING,
+    SCRIPT_DONE,
+    SCRIPT_STOPPED,
+    SCRIPT_ABORTED_TILT,
+    SCRIPT_ABORTED_SETTLE
+} ScriptState;
+
+typedef struct _SCRIPT_STEP
+{
+    uint8_t op;
+    uint8_t jump;           // index of the matching repeat or end
+    float value;
+} SCRIPT_STEP;
+
+// What a script drives, supplied by the application
+typedef struct _SCRIPT_MOTION
+{
+    void (*drive)(float meters);
+    void (*rotate)(int16_t degrees);
+    void (*stop)(void);
+    bool (*isMoving)(void);
+    float (*getTilt)(void);
+} SCRIPT_MOTION;
+
+typedef struct _SCRIPT_STATUS
+{
+    ScriptState state;
+    uint8_t steps;
+    uint8_t step;           // the step running, or the one that aborted
+    uint32_t runs;
+    float abortTilt;        // deg, 0 if off
+    float lastTilt;
+} SCRIPT_STATUS;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initScript(const SCRIPT_MOTION* motion);
+void beginScriptLoad(void);
+bool isScriptLoading(void);
+bool addScriptLine(USER_DATA* data);
+bool startScript(void);
+void stopScript(void);
+bool isScriptRunning(void);
+void stepScript(void);
+SCRIPT_STATUS getScriptStatus(void);
+void printScript(void);
+
+#endif
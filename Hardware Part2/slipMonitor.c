@@ -0,0 +1,201 @@
+// Slip Monitor Library
+// Xavier
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    80 MHz
+
+// Hardware configuration:
+// OPB876N55 optical interrupters on both wheels, MPU6050 accel x and gyro z
+
+// Cross-checks the wheel increments of each control tick against the IMU:
+//   - a count jump no wheel could make is a glitch, the bad wheel is rebuilt
+//     from the other wheel and the gyro yaw
+//   - a driven wheel that produces no tabs is stalled
+//   - wheels whose yaw rate disagrees with the gyro, or whose forward speed
+//     disagrees with the accelerometer, are slipping
+// A tick sees whole tabs only, one tab in 25 ms is 40 cm/s or 143 deg/s
+// of yaw, so the slip check averages the residuals over SLIP_WINDOW_TICKS
+// and allows the one tab per wheel the window can be off by.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <math.h>
+#include "slipMonitor.h"
+#include "odometry.h"
+#include "motorControl.h"
+
+#define PI 3.1415
+
+#define SLIP_ACCEL_SIGN   1.0     // set to -1.0 if accel x points backward
+#define SLIP_GRAVITY_CMS2 981.0   // 1 g in cm/s^2
+#define SLIP_GRAVITY_LP   0.02    // low-pass that tracks gravity leaking into accel x with tilt
+#define SLIP_ACCEL_BLEND  0.9     // share of the velocity estimate carried by the accelerometer
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+SLIP_COUNTERS slipCounters;
+uint8_t slipFlags = 0;
+
+uint8_t stallTicks[2];
+uint8_t slipTicks = 0;
+
+float yawResiduals[SLIP_WINDOW_TICKS];       // deg/s, ring of the last ticks
+float velocityResiduals[SLIP_WINDOW_TICKS];  // cm/s
+float yawResidualSum = 0;
+float velocityResidualSum = 0;
+uint8_t residualIndex = 0;
+
+float gravityX = 0;       // cm/s^2
+float accelVelocity = 0;  // cm/s
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initSlipMonitor(void)
+{
+    stallTicks[LEFT_WHEEL] = 0;
+    stallTicks[RIGHT_WHEEL] = 0;
+    slipTicks = 0;
+    slipFlags = 0;
+    for (residualIndex = 0; residualIndex < SLIP_WINDOW_TICKS; residualIndex++)
+    {
+        yawResiduals[residualIndex] = 0;
+        velocityResiduals[residualIndex] = 0;
+    }
+    residualIndex = 0;
+    yawResidualSum = 0;
+    velocityResidualSum = 0;
+    gravityX = 0;
+    accelVelocity = 0;
+    clearSlipCounters();
+}
+
+// Called from updateOdometry with the wheel increments (cm) of this tick
+// Glitched increments are replaced in place, returns the SLIP_FLAG_ bits
+uint8_t checkWheelConsistency(float* dLeft, float* dRight, float gyroZ, float accelX, float dt)
+{
+    uint8_t flags = 0;
+    uint8_t side;
+    float d[2];
+
+    // Difference between the wheels the gyro says there should be
+    float gyroYawCm = ODOMETRY_GYRO_SIGN * gyroZ * dt * PI / 180.0 * ODOMETRY_WHEEL_BASE;
+
+    // Glitch
+    if (fabs(*dLeft) > SLIP_MAX_TABS * ODOMETRY_CM_PER_TAB)
+    {
+        *dLeft = (fabs(*dRight) > SLIP_MAX_TABS * ODOMETRY_CM_PER_TAB) ? 0 : *dRight - gyroYawCm;
+        flags |= SLIP_FLAG_GLITCH_LEFT;
+        slipCounters.glitch[LEFT_WHEEL]++;
+    }
+    if (fabs(*dRight) > SLIP_MAX_TABS * ODOMETRY_CM_PER_TAB)
+    {
+        *dRight = *dLeft + gyroYawCm;
+        flags |= SLIP_FLAG_GLITCH_RIGHT;
+        slipCounters.glitch[RIGHT_WHEEL]++;
+    }
+
+    // Stall
+    d[LEFT_WHEEL] = *dLeft;
+    d[RIGHT_WHEEL] = *dRight;
+    for (side = LEFT_WHEEL; side <= RIGHT_WHEEL; side++)
+    {
+        if ((getWheelDirection(side) != 0) && (d[side] == 0))
+        {
+            if (stallTicks[side] < SLIP_STALL_TICKS)
+            {
+                stallTicks[side]++;
+                if (stallTicks[side] == SLIP_STALL_TICKS)
+                    slipCounters.stall[side]++;
+            }
+        }
+        else
+        {
+            stallTicks[side] = 0;
+        }
+    }
+    if (stallTicks[LEFT_WHEEL] == SLIP_STALL_TICKS)
+        flags |= SLIP_FLAG_STALL_LEFT;
+    if (stallTicks[RIGHT_WHEEL] == SLIP_STALL_TICKS)
+        flags |= SLIP_FLAG_STALL_RIGHT;
+
+    // Yaw rate implied by the wheels against the gyro
+    float wheelYawRate = (*dRight - *dLeft) / ODOMETRY_WHEEL_BASE / dt * 180.0 / PI;
+    float yawResidual = wheelYawRate - ODOMETRY_GYRO_SIGN * gyroZ;
+
+    // Forward speed of the wheels against the integrated accelerometer
+    // The accelerometer carries the fast part, the wheels pull it back slowly so it can't drift away
+    float accel = SLIP_ACCEL_SIGN * accelX * SLIP_GRAVITY_CMS2;
+    gravityX += SLIP_GRAVITY_LP * (accel - gravityX);
+    float wheelVelocity = (*dLeft + *dRight) / 2 / dt;
+    accelVelocity = SLIP_ACCEL_BLEND * (accelVelocity + (accel - gravityX) * dt) + (1 - SLIP_ACCEL_BLEND) * wheelVelocity;
+    float velocityResidual = wheelVelocity - accelVelocity;
+
+    // Averages over the window
+    yawResidualSum += yawResidual - yawResiduals[residualIndex];
+    velocityResidualSum += velocityResidual - velocityResiduals[residualIndex];
+    yawResiduals[residualIndex] = yawResidual;
+    velocityResiduals[residualIndex] = velocityResidual;
+    residualIndex = (residualIndex + 1) % SLIP_WINDOW_TICKS;
+
+    float windowTime = SLIP_WINDOW_TICKS * dt;
+    float yawQuantum = 2 * ODOMETRY_CM_PER_TAB / ODOMETRY_WHEEL_BASE * 180.0 / PI / windowTime;
+    float velocityQuantum = ODOMETRY_CM_PER_TAB / windowTime;
+
+    if ((fabs(yawResidualSum / SLIP_WINDOW_TICKS) > SLIP_YAW_TOLERANCE + yawQuantum)
+        || (fabs(velocityResidualSum / SLIP_WINDOW_TICKS) > SLIP_VEL_TOLERANCE + velocityQuantum))
+    {
+        if (slipTicks < SLIP_CONFIRM_TICKS)
+        {
+            slipTicks++;
+            if (slipTicks == SLIP_CONFIRM_TICKS)
+                slipCounters.slip++;
+        }
+    }
+    else
+    {
+        slipTicks = 0;
+    }
+    if (slipTicks == SLIP_CONFIRM_TICKS)
+        flags |= SLIP_FLAG_SLIP;
+
+    slipFlags = flags;
+    return flags;
+}
+
+uint8_t getSlipFlags(void)
+{
+    return slipFlags;
+}
+
+// Forward velocity from the accelerometer blend in cm/s
+float getSlipVelocity(void)
+{
+    return accelVelocity;
+}
+
+SLIP_COUNTERS getSlipCounters(void)
+{
+    return slipCounters;
+}
+
+void clearSlipCounters(void)
+{
+    slipCounters.slip = 0;
+    slipCounters.stall[LEFT_WHEEL] = 0;
+    slipCounters.stall[RIGHT_WHEEL] = 0;
+    slipCounters.glitch[LEFT_WHEEL] = 0;
+    slipCounters.glitch[RIGHT_WHEEL] = 0;
+}
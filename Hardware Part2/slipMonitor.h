@@ -0,0 +1,58 @@
+// Slip Monitor Library
+// Xavier
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    80 MHz
+
+// Hardware configuration:
+// OPB876N55 optical interrupters on both wheels, MPU6050 accel x and gyro z
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef SLIPMONITOR_H_
+#define SLIPMONITOR_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// General Defines
+#define SLIP_WINDOW_TICKS    8       // residuals are averaged over this many ticks (200 ms)
+#define SLIP_YAW_TOLERANCE   60.0    // deg/s the wheels may disagree with the gyro, on top of one tab per wheel
+#define SLIP_VEL_TOLERANCE   40.0    // cm/s the wheels may disagree with the accelerometer, on top of one tab
+#define SLIP_MAX_TABS        8       // more tabs than this in one tick is impossible (320 cm/s)
+#define SLIP_STALL_TICKS     8       // driven ticks without a tab before calling it a stall
+#define SLIP_CONFIRM_TICKS   3       // consecutive bad ticks before flagging slip
+
+#define SLIP_FLAG_SLIP         1     // wheels turning faster than the robot moves
+#define SLIP_FLAG_STALL_LEFT   2     // left wheel driven but not turning
+#define SLIP_FLAG_STALL_RIGHT  4     // right wheel driven but not turning
+#define SLIP_FLAG_GLITCH_LEFT  8     // left count jumped this tick and was replaced
+#define SLIP_FLAG_GLITCH_RIGHT 16    // right count jumped this tick and was replaced
+
+// Structs
+typedef struct _SLIP_COUNTERS
+{
+    uint32_t slip;
+    uint32_t stall[2];
+    uint32_t glitch[2];
+} SLIP_COUNTERS;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initSlipMonitor(void);
+uint8_t checkWheelConsistency(float* dLeft, float* dRight, float gyroZ, float accelX, float dt);
+uint8_t getSlipFlags(void);
+float getSlipVelocity(void);
+SLIP_COUNTERS getSlipCounters(void);
+void clearSlipCounters(void);
+
+#endif
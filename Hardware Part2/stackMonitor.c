@@ -0,0 +1,111 @@
+// Stack Monitor Library
+// Xavier
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    80 MHz
+
+// Hardware configuration: -
+
+// Thread mode never switches to the process stack, so main and every
+// interrupt share the one stack the linker reserves (--stack_size in the
+// project options). initStackMonitor() fills the unused part with a pattern
+// first thing in main, and the high-water mark is the lowest word that no
+// longer holds it. Scanning is done on request, nothing is added to the
+// control loops except one compare in the tick.
+// The main loop's own depth is marked once, so the report can split the
+// high-water mark into what the main loop reaches with nothing preempting it
+// and what the deepest call chain plus nested interrupts add on top. The
+// depth at each SysTick entry is sampled too. SysTick preempts everything, so
+// its entry sees main, PendSV and any other ISR stacked up at that moment.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "stackMonitor.h"
+#include "uart0.h"
+
+// Linker symbols for the .stack section
+extern uint32_t __stack;
+extern uint32_t __STACK_END;
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+uint32_t mainStackDepth = 0;
+uint32_t tickStackDepth = 0;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// Bytes in use below the end of the stack at the caller
+uint32_t stackDepth(void)
+{
+    volatile uint32_t marker;
+    return (uint32_t)&__STACK_END - (uint32_t)&marker;
+}
+
+// First thing in main, before anything deep runs
+void initStackMonitor(void)
+{
+    volatile uint32_t marker;
+    uint32_t* p = &__stack;
+    uint32_t* live = (uint32_t*)((uint32_t)&marker - STACK_GUARD);
+
+    while (p < live)
+        *p++ = STACK_PAINT;
+
+    mainStackDepth = 0;
+    tickStackDepth = 0;
+}
+
+// Called from the main loop itself, not from a function it calls
+void markMainStack(void)
+{
+    mainStackDepth = stackDepth();
+}
+
+// Called from the SysTick ISR
+void sampleTickStack(void)
+{
+    uint32_t depth = stackDepth();
+    if (depth > tickStackDepth)
+        tickStackDepth = depth;
+}
+
+STACK_USAGE getStackUsage(void)
+{
+    STACK_USAGE usage;
+    uint32_t* p = &__stack;
+
+    while ((p < &__STACK_END) && (*p == STACK_PAINT))
+        p++;
+
+    usage.size = (uint32_t)&__STACK_END - (uint32_t)&__stack;
+    usage.highWater = (uint32_t)&__STACK_END - (uint32_t)p;
+    usage.mainDepth = mainStackDepth;
+    usage.tickDepth = tickStackDepth;
+    return usage;
+}
+
+void printStackUsage(void)
+{
+    STACK_USAGE usage = getStackUsage();
+
+    printfUart0("Stack: %u bytes at 0x%x\n", usage.size, (uint32_t)&__stack);
+    printfUart0("  high-water   %u, %u free\n", usage.highWater, usage.size - usage.highWater);
+    printfUart0("  main loop    %u\n", usage.mainDepth);
+    printfUart0("  calls + isrs %u above the main loop\n", usage.highWater - usage.mainDepth);
+    printfUart0("  at tick      %u deepest sampled\n", usage.tickDepth);
+    if (usage.size - usage.highWater < STACK_GUARD)
+        printfUart0("  WARNING: the paint is gone, the stack may have overflowed\n");
+}
@@ -0,0 +1,47 @@
+// Stack Monitor Library
+// Xavier
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    80 MHz
+
+// Hardware configuration: -
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef STACKMONITOR_H_
+#define STACKMONITOR_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// General Defines
+#define STACK_PAINT     0xDEADBEEF  // unused stack words hold this
+#define STACK_GUARD     64          // bytes below the live stack pointer left unpainted
+
+// Structs
+typedef struct _STACK_USAGE
+{
+    uint32_t size;          // bytes reserved for the stack by the linker
+    uint32_t highWater;     // deepest the stack has ever been, from the paint
+    uint32_t mainDepth;     // depth of the main loop with nothing preempting it
+    uint32_t tickDepth;     // deepest the stack was when SysTick was entered
+} STACK_USAGE;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initStackMonitor(void);
+void markMainStack(void);
+void sampleTickStack(void);
+STACK_USAGE getStackUsage(void);
+void printStackUsage(void);
+
+#endif
@@ -0,0 +1,310 @@
+// Telemetry Library
+// Xavier
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    80 MHz
+
+// Hardware configuration:
+// UART Interface:
+//   U0TX (PA1) shared with the CLI
+
+// Binary packets on the CLI UART, decoded on the host by
+// tools/telemetry_decode.py. A packet is
+//   type (1), sequence (2), time us (4), then by type
+//     TELEMETRY_PACKET_SAMPLE: channel mask (2), the selected channels
+//     TELEMETRY_PACKET_TIMING: one scheduler task's TASK_TIMING in cycles
+//   CRC-16/CCITT (2) over everything before it
+// COBS encoded so it has no zero bytes, with a zero before and after it.
+// CLI text has no zero bytes either, so the host can tell the two apart
+// from the delimiters alone.
+// A packet goes into the UART ring whole or not at all, with interrupts
+// masked, so text printed at the same time never ends up in the middle of one.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "telemetry.h"
+#include "timing.h"
+#include "timebase.h"
+#include "scheduler.h"
+#include "uart0.h"
+
+#define TELEMETRY_CRC_INIT  0xFFFF
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+bool telemetryEnabled = false;
+uint16_t telemetryChannels = TELEMETRY_CH_DEFAULT;
+uint8_t telemetryDivider = 1;       // a sample every nth control tick
+uint8_t telemetryCountdown = 1;
+uint16_t telemetrySequence = 0;
+uint8_t telemetryTimingTask = 0;    // next task to report
+TELEMETRY_STATS telemetryStats;
+
+// CRC-16/CCITT (poly 0x1021) a nibble at a time
+const uint16_t crc16Table[16] =
+{
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initTelemetry(void)
+{
+    telemetryEnabled = false;
+    telemetryChannels = TELEMETRY_CH_DEFAULT;
+    telemetryDivider = 1;
+    telemetryCountdown = 1;
+    telemetrySequence = 0;
+    telemetryTimingTask = 0;
+    telemetryStats.sent = 0;
+    telemetryStats.skipped = 0;
+}
+
+void enableTelemetry(bool enable)
+{
+    telemetryCountdown = 1;
+    telemetryEnabled = enable;
+}
+
+void setTelemetryChannels(uint16_t channels)
+{
+    telemetryChannels = channels;
+}
+
+// 1 sends every control tick, 0 is taken as 1
+void setTelemetryDivider(uint8_t divider)
+{
+    telemetryDivider = (divider == 0) ? 1 : divider;
+    telemetryCountdown = 1;
+}
+
+uint16_t crc16(const uint8_t* data, uint16_t length)
+{
+    uint16_t crc = TELEMETRY_CRC_INIT;
+
+    while (length--)
+    {
+        crc = (crc << 4) ^ crc16Table[(crc >> 12) ^ (*data >> 4)];
+        crc = (crc << 4) ^ crc16Table[(crc >> 12) ^ (*data & 0x0F)];
+        data++;
+    }
+    return crc;
+}
+
+// Returns the encoded length, out needs length + length / 254 + 1 bytes
+uint16_t cobsEncode(const uint8_t* in, uint16_t length, uint8_t* out)
+{
+    uint16_t read = 0;
+    uint16_t write = 1;
+    uint16_t code = 0;          // where the current block's length goes
+    uint8_t run = 1;
+
+    while (read < length)
+    {
+        if (in[read] == 0)
+        {
+            out[code] = run;
+            code = write++;
+            run = 1;
+        }
+        else
+        {
+            out[write++] = in[read];
+            if (++run == 0xFF)
+            {
+                out[code] = run;
+                code = write++;
+                run = 1;
+            }
+        }
+        read++;
+    }
+    out[code] = run;
+    return write;
+}
+
+void putU16(uint8_t* p, uint16_t v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+}
+
+void putU32(uint8_t* p, uint32_t v)
+{
+    p[0] = v;
+    p[1] = v >> 8;
+    p[2] = v >> 16;
+    p[3] = v >> 24;
+}
+
+void putF32(uint8_t* p, float f)
+{
+    union { float f; uint32_t u; } v;
+    v.f = f;
+    putU32(p, v.u);
+}
+
+// Header into packet, returns its length
+// The sequence is filled in by finishPacket()
+uint16_t startPacket(uint8_t* packet, uint8_t type)
+{
+    packet[0] = type;
+    putU16(&packet[1], 0);
+    putU32(&packet[3], (uint32_t)nowUs());
+    return 7;
+}
+
+// Adds the sequence and CRC, encodes and queues the whole packet or nothing
+// packet needs 2 bytes after length for the CRC, returns false if it was skipped
+// Packets are built from SysTick and from main, so the sequence is taken and
+// the frame queued with interrupts masked, the numbers go out in order
+// A skipped packet still uses its number, the host counts it as a gap
+bool finishPacket(uint8_t* packet, uint16_t length)
+{
+    uint8_t frame[TELEMETRY_MAX_FRAME];
+    uint16_t size;
+    uint32_t primask;
+    bool queued;
+
+    primask = _disable_interrupts();
+    putU16(&packet[1], telemetrySequence++);
+    putU16(&packet[length], crc16(packet, length));
+    length += 2;
+
+    frame[0] = 0;
+    size = 1 + cobsEncode(packet, length, &frame[1]);
+    frame[size++] = 0;
+
+    queued = writeUart0((char*)frame, size);
+    if (queued)
+        telemetryStats.sent++;
+    else
+        telemetryStats.skipped++;
+    _restore_interrupts(primask);
+    return queued;
+}
+
+// Called every control tick, true when this tick's sample should be sent
+bool isTelemetryDue(void)
+{
+    if (!telemetryEnabled || (telemetryChannels & ~TELEMETRY_CH_TIMING) == 0)
+        return false;
+    if (--telemetryCountdown != 0)
+        return false;
+    telemetryCountdown = telemetryDivider;
+    return true;
+}
+
+void sendTelemetrySample(TELEMETRY_SAMPLE* sample)
+{
+    uint8_t packet[TELEMETRY_MAX_PACKET + 2];
+    uint16_t length = startPacket(packet, TELEMETRY_PACKET_SAMPLE);
+    uint16_t channels = telemetryChannels & ~TELEMETRY_CH_TIMING;
+    uint8_t i;
+
+    putU16(&packet[length], channels);
+    length += 2;
+
+    if (channels & TELEMETRY_CH_TILT)
+    {
+        putF32(&packet[length], sample->tilt);
+        length += 4;
+    }
+    if (channels & TELEMETRY_CH_GYRO)
+    {
+        for (i = 0; i < 3; i++, length += 4)
+            putF32(&packet[length], sample->gyro[i]);
+    }
+    if (channels & TELEMETRY_CH_ACCEL)
+    {
+        for (i = 0; i < 3; i++, length += 4)
+            putF32(&packet[length], sample->accel[i]);
+    }
+    if (channels & TELEMETRY_CH_PWM)
+    {
+        for (i = 0; i < 2; i++, length += 2)
+            putU16(&packet[length], sample->pwm[i]);
+    }
+    if (channels & TELEMETRY_CH_WHEELS)
+    {
+        for (i = 0; i < 2; i++, length += 4)
+            putU32(&packet[length], sample->count[i]);
+        for (i = 0; i < 2; i++, length += 4)
+            putF32(&packet[length], sample->rate[i]);
+    }
+    if (channels & TELEMETRY_CH_PID)
+    {
+        for (i = 0; i < 4; i++, length += 4)
+            putF32(&packet[length], sample->pid[i]);
+    }
+    if (channels & TELEMETRY_CH_POSE)
+    {
+        for (i = 0; i < 3; i++, length += 4)
+            putF32(&packet[length], sample->pose[i]);
+    }
+
+    finishPacket(packet, length);
+}
+
+// Low priority task, one scheduler task's timing per call
+// The host gets the deadline monitor's numbers without the text dump of timing
+void sendTelemetryTiming(void)
+{
+    uint8_t packet[TELEMETRY_MAX_PACKET + 2];
+    uint16_t length;
+    TASK_TIMING t;
+    uint8_t i;
+
+    if (!telemetryEnabled || !(telemetryChannels & TELEMETRY_CH_TIMING) || getTaskCount() == 0)
+        return;
+
+    if (telemetryTimingTask >= getTaskCount())
+        telemetryTimingTask = 0;
+    t = getTaskTiming(telemetryTimingTask);
+
+    length = startPacket(packet, TELEMETRY_PACKET_TIMING);
+    packet[length++] = telemetryTimingTask;
+    packet[length++] = TIMING_CYCLES_PER_US;
+    for (i = 0; i < 8; i++)
+        packet[length + i] = 0;
+    for (i = 0; (i < 8) && (t.name[i] != '\0'); i++)
+        packet[length + i] = t.name[i];
+    length += 8;
+    putU32(&packet[length], t.period);
+    putU32(&packet[length + 4], t.runs);
+    putU32(&packet[length + 8], (t.runs != 0) ? t.minExec : 0);
+    putU32(&packet[length + 12], (t.runs != 0) ? (uint32_t)(t.totalExec / t.runs) : 0);
+    putU32(&packet[length + 16], t.maxExec);
+    putU32(&packet[length + 20], t.maxJitter);
+    putU32(&packet[length + 24], t.misses);
+    length += 28;
+    for (i = 0; i < TIMING_BUCKETS; i++, length += 4)
+        putU32(&packet[length], t.execHistogram[i]);
+    for (i = 0; i < TIMING_BUCKETS; i++, length += 4)
+        putU32(&packet[length], t.jitterHistogram[i]);
+
+    telemetryTimingTask++;
+    finishPacket(packet, length);
+}
+
+void printTelemetryStatus(void)
+{
+    printfUart0("telemetry %s   channels 0x%x   every %u control ticks\n", telemetryEnabled ? "on" : "off",
+                telemetryChannels, telemetryDivider);
+    printfUart0("  packets sent %u   skipped %u (uart ring full)\n", telemetryStats.sent, telemetryStats.skipped);
+    printfUart0("  channels: 1 tilt, 2 gyro, 4 accel, 8 pwm, 16 wheels, 32 pid, 64 pose, 128 timing\n");
+}
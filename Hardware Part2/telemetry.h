@@ -0,0 +1,85 @@
+// Telemetry Library
+// Xavier
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    80 MHz
+
+// Hardware configuration:
+// UART Interface:
+//   U0TX (PA1) shared with the CLI
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// General Defines
+#define TELEMETRY_MAX_PACKET    128     // bytes before COBS and CRC
+#define TELEMETRY_MAX_FRAME     (TELEMETRY_MAX_PACKET + 2 + TELEMETRY_MAX_PACKET / 254 + 1 + 2) // CRC, COBS overhead, delimiters
+
+// Packet types, first byte of every packet
+#define TELEMETRY_PACKET_SAMPLE 1
+#define TELEMETRY_PACKET_TIMING 2
+#define TELEMETRY_PACKET_SCOPE_HEADER 3 // scope.c
+#define TELEMETRY_PACKET_SCOPE_DATA   4
+
+// Sample channels, the payload holds the selected ones in bit order
+// All values little-endian, f = float32, i = int16, l = int32
+#define TELEMETRY_CH_TILT       0x0001  // tilt f (deg)
+#define TELEMETRY_CH_GYRO       0x0002  // gx gy gz f (deg/s)
+#define TELEMETRY_CH_ACCEL      0x0004  // ax ay az f (g)
+#define TELEMETRY_CH_PWM        0x0008  // left right i, negative is backward
+#define TELEMETRY_CH_WHEELS     0x0010  // left right count l, left right rate f (tabs/s)
+#define TELEMETRY_CH_PID        0x0020  // error integral derivative output f (LQR: output only)
+#define TELEMETRY_CH_POSE       0x0040  // x y f (cm), theta f (rad)
+#define TELEMETRY_CH_TIMING     0x0080  // per-task timing packets, not part of the sample
+#define TELEMETRY_CH_DEFAULT    (TELEMETRY_CH_TILT | TELEMETRY_CH_GYRO | TELEMETRY_CH_PWM | TELEMETRY_CH_PID)
+
+// Structs
+typedef struct _TELEMETRY_SAMPLE
+{
+    float tilt;
+    float gyro[3];
+    float accel[3];
+    int16_t pwm[2];
+    int32_t count[2];
+    float rate[2];
+    float pid[4];
+    float pose[3];
+} TELEMETRY_SAMPLE;
+
+typedef struct _TELEMETRY_STATS
+{
+    uint32_t sent;
+    uint32_t skipped;       // no room in the UART ring, the whole packet was left out
+} TELEMETRY_STATS;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initTelemetry(void);
+void putU16(uint8_t* p, uint16_t v);
+void putU32(uint8_t* p, uint32_t v);
+void putF32(uint8_t* p, float f);
+uint16_t startPacket(uint8_t* packet, uint8_t type);
+bool finishPacket(uint8_t* packet, uint16_t length);
+void enableTelemetry(bool enable);
+void setTelemetryChannels(uint16_t channels);
+void setTelemetryDivider(uint8_t divider);
+bool isTelemetryDue(void);
+void sendTelemetrySample(TELEMETRY_SAMPLE* sample);
+void sendTelemetryTiming(void);
+void printTelemetryStatus(void);
+
+#endif
@@ -0,0 +1,106 @@
+// Timebase Library
+// Xavier
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    80 MHz
+
+// Hardware configuration:
+// WTIMER2 as a free-running 64-bit up counter (A+B concatenated)
+
+// Monotonic time for the whole program. At 80 MHz the 64-bit counter wraps
+// after 7,000 years, so no interrupt is needed to extend it and it keeps
+// counting through every ISR. Waits are written as deadlines that the
+// caller polls, so the main loop and the tasks keep running in between.
+// delayUs() is the only blocking wait and is meant for start-up code.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "tm4c123gh6pm.h"
+#include "timebase.h"
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// WTIMER2 clock must already be on (initHw)
+void initTimebase(void)
+{
+    WTIMER2_CTL_R &= ~TIMER_CTL_TAEN;                // turn-off counter before reconfiguring
+    WTIMER2_CFG_R = TIMER_CFG_32_BIT_TIMER;          // configure as 64-bit timer (A+B) on a wide timer
+    WTIMER2_TAMR_R = TIMER_TAMR_TAMR_PERIOD | TIMER_TAMR_TACDIR; // configure for periodic mode, count up
+    WTIMER2_TAILR_R = 0xFFFFFFFF;                    // count the full 64 bits
+    WTIMER2_TBILR_R = 0xFFFFFFFF;
+    WTIMER2_TAV_R = 0;                               // start from zero
+    WTIMER2_TBV_R = 0;
+    WTIMER2_CTL_R |= TIMER_CTL_TAEN;                 // turn-on counter
+}
+
+uint64_t nowTicks(void)
+{
+    uint32_t high;
+    uint32_t low;
+
+    // Re-read if the low half carried into the high half in between
+    do
+    {
+        high = WTIMER2_TBV_R;
+        low = WTIMER2_TAV_R;
+    }
+    while (high != WTIMER2_TBV_R);
+
+    return ((uint64_t)high << 32) | low;
+}
+
+uint64_t nowUs(void)
+{
+    return nowTicks() / TIMEBASE_TICKS_PER_US;
+}
+
+DEADLINE deadlineIn(uint32_t us)
+{
+    return nowUs() + us;
+}
+
+bool deadlinePassed(DEADLINE deadline)
+{
+    return nowUs() >= deadline;
+}
+
+// For periodic steps: if the deadline has passed, move it one period later
+// (from the old deadline, so the steps don't drift) and return true
+bool deadlineAdvance(DEADLINE* deadline, uint32_t periodUs)
+{
+    if (!deadlinePassed(*deadline))
+        return false;
+    *deadline += periodUs;
+    return true;
+}
+
+// Time left before the deadline, 0 once it has passed
+uint32_t usUntil(DEADLINE deadline)
+{
+    uint64_t now = nowUs();
+    return (now >= deadline) ? 0 : (uint32_t)(deadline - now);
+}
+
+uint32_t usSince(uint64_t startUs)
+{
+    return (uint32_t)(nowUs() - startUs);
+}
+
+// Blocking, but unlike waitMicrosecond() it stays correct when interrupts
+// take time away from it
+void delayUs(uint32_t us)
+{
+    DEADLINE deadline = deadlineIn(us);
+    while (!deadlinePassed(deadline));
+}
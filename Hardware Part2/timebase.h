@@ -0,0 +1,48 @@
+// Timebase Library
+// Xavier
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    80 MHz
+
+// Hardware configuration:
+// WTIMER2 as a free-running 64-bit up counter (A+B concatenated)
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef TIMEBASE_H_
+#define TIMEBASE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "clock.h"
+
+// General Defines
+#define TIMEBASE_TICKS_PER_US SYSTEM_CLOCK_MHZ    // WTIMER2 counts the system clock
+
+// Absolute time in microseconds since initTimebase()
+typedef uint64_t DEADLINE;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initTimebase(void);
+uint64_t nowTicks(void);
+uint64_t nowUs(void);
+
+DEADLINE deadlineIn(uint32_t us);
+bool deadlinePassed(DEADLINE deadline);
+bool deadlineAdvance(DEADLINE* deadline, uint32_t periodUs);
+uint32_t usUntil(DEADLINE deadline);
+uint32_t usSince(uint64_t startUs);
+
+void delayUs(uint32_t us);
+
+#endif
@@ -0,0 +1,150 @@
+// Task Timing Library
+// Xavier
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    80 MHz
+
+// Hardware configuration:
+// Cortex-M4 DWT cycle counter
+
+// The scheduler calls startTaskTiming() before and endTaskTiming() after
+// every task it runs. That costs two reads of CYCCNT and a few adds per run, cheap enough
+// to leave on in the control loops. A deadline is missed when the run ends
+// after the next release was due.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "tm4c123gh6pm.h"
+#include "timing.h"
+#include "uart0.h"
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+TASK_TIMING taskTiming[TIMING_TASKS];
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initTiming(void)
+{
+    uint8_t i;
+
+    NVIC_DBG_INT_R |= NVIC_DBG_INT_TRCENA;           // turn-on DWT
+    DWT_CYCCNT_R = 0;
+    DWT_CTRL_R |= DWT_CTRL_CYCCNTENA;                // turn-on cycle counter
+
+    for (i = 0; i < TIMING_TASKS; i++)
+        registerTaskTiming(i, "-", 0);
+}
+
+void registerTaskTiming(uint8_t task, char* name, uint32_t periodCycles)
+{
+    taskTiming[task].name = name;
+    taskTiming[task].period = periodCycles;
+    clearTaskTiming(task);
+}
+
+void clearTaskTiming(uint8_t task)
+{
+    uint8_t i;
+    TASK_TIMING* t = &taskTiming[task];
+
+    t->runs = 0;
+    t->minExec = 0xFFFFFFFF;
+    t->maxExec = 0;
+    t->totalExec = 0;
+    t->maxJitter = 0;
+    t->misses = 0;
+    for (i = 0; i < TIMING_BUCKETS; i++)
+    {
+        t->execHistogram[i] = 0;
+        t->jitterHistogram[i] = 0;
+    }
+}
+
+void startTaskTiming(uint8_t task)
+{
+    uint32_t now = DWT_CYCCNT_R;
+    TASK_TIMING* t = &taskTiming[task];
+    uint32_t jitter;
+    uint8_t bucket = 0;
+
+    if (t->runs != 0)
+    {
+        jitter = now - t->lastStart;
+        jitter = (jitter > t->period) ? jitter - t->period : t->period - jitter;
+        if (jitter > t->maxJitter)
+            t->maxJitter = jitter;
+
+        jitter /= TIMING_CYCLES_PER_US;
+        while (jitter != 0 && bucket < TIMING_BUCKETS - 1)
+        {
+            jitter >>= 1;
+            bucket++;
+        }
+        t->jitterHistogram[bucket]++;
+    }
+    t->lastStart = now;
+}
+
+void endTaskTiming(uint8_t task)
+{
+    TASK_TIMING* t = &taskTiming[task];
+    uint32_t exec = DWT_CYCCNT_R - t->lastStart;
+    uint32_t bucket;
+
+    t->runs++;
+    t->totalExec += exec;
+    if (exec < t->minExec)
+        t->minExec = exec;
+    if (exec > t->maxExec)
+        t->maxExec = exec;
+
+    if (t->period != 0)
+    {
+        if (exec >= t->period)
+            t->misses++;
+        bucket = (uint64_t)exec * TIMING_BUCKETS / t->period;
+        t->execHistogram[bucket < TIMING_BUCKETS ? bucket : TIMING_BUCKETS - 1]++;
+    }
+}
+
+TASK_TIMING getTaskTiming(uint8_t task)
+{
+    return taskTiming[task];
+}
+
+void printTaskTiming(uint8_t task)
+{
+    TASK_TIMING t = taskTiming[task];
+    uint8_t i;
+
+    if (t.runs == 0)
+    {
+        printfUart0("%s: no runs\n", t.name);
+        return;
+    }
+
+    printfUart0("%s: period %u us   runs %u   missed %u\n", t.name, t.period / TIMING_CYCLES_PER_US, t.runs, t.misses);
+    printfUart0("  exec us   min %u   avg %u   max %u   max jitter %u us\n", t.minExec / TIMING_CYCLES_PER_US,
+                (uint32_t)(t.totalExec / t.runs) / TIMING_CYCLES_PER_US, t.maxExec / TIMING_CYCLES_PER_US, t.maxJitter / TIMING_CYCLES_PER_US);
+    printfUart0("  exec/period 1/8ths:");
+    for (i = 0; i < TIMING_BUCKETS; i++)
+        printfUart0(" %u", t.execHistogram[i]);
+    printfUart0("\n  jitter <1,2,4..64+ us:");
+    for (i = 0; i < TIMING_BUCKETS; i++)
+        printfUart0(" %u", t.jitterHistogram[i]);
+    printfUart0("\n");
+}
@@ -0,0 +1,66 @@
+// Task Timing Library
+// Xavier
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    80 MHz
+
+// Hardware configuration:
+// Cortex-M4 DWT cycle counter
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef TIMING_H_
+#define TIMING_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "clock.h"
+
+// DWT registers (not in tm4c123gh6pm.h)
+#define DWT_CTRL_R              (*((volatile uint32_t *)0xE0001000))
+#define DWT_CYCCNT_R            (*((volatile uint32_t *)0xE0001004))
+#define DWT_CTRL_CYCCNTENA      0x00000001  // Enable cycle counter
+#define NVIC_DBG_INT_TRCENA     0x01000000  // Enable DWT and ITM (DEMCR)
+
+// General Defines
+#define TIMING_CYCLES_PER_US    SYSTEM_CLOCK_MHZ
+#define TIMING_BUCKETS          8
+
+#define TIMING_TASKS            8     // one slot per scheduler task
+
+// Structs
+typedef struct _TASK_TIMING
+{
+    char* name;
+    uint32_t period;                           // cycles between releases
+    uint32_t lastStart;                        // CYCCNT when the last run started
+    uint32_t runs;
+    uint32_t minExec;                          // cycles
+    uint32_t maxExec;                          // cycles
+    uint64_t totalExec;                        // cycles, for the average
+    uint32_t maxJitter;                        // cycles the release was off the period
+    uint32_t misses;                           // runs that finished after the next release
+    uint32_t execHistogram[TIMING_BUCKETS];    // execution time in eighths of the period
+    uint32_t jitterHistogram[TIMING_BUCKETS];  // release jitter, <1, <2, <4 ... >=64 us
+} TASK_TIMING;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initTiming(void);
+void registerTaskTiming(uint8_t task, char* name, uint32_t periodCycles);
+void clearTaskTiming(uint8_t task);
+void startTaskTiming(uint8_t task);
+void endTaskTiming(uint8_t task);
+TASK_TIMING getTaskTiming(uint8_t task);
+void printTaskTiming(uint8_t task);
+
+#endif
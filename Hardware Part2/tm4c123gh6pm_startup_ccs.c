@@ -30,8 +30,6 @@
 //
 //*****************************************************************************
 void ResetISR(void);
-static void NmiSR(void);
-static void FaultISR(void);
 static void IntDefaultHandler(void);
 
 //*****************************************************************************
@@ -60,8 +58,12 @@ extern void IRdecoder(void);
 extern void wideTimer3Isr(void); // IR
 extern void wideTimer1Isr(void); // Left Wheel
 extern void wideTimer5Isr(void); // Right Wheel
-extern void balancePID(void); // PID (Balance)
-extern void pidISR(void); // PID
+extern void sysTickIsr(void); // Scheduler tick (balance runs here)
+extern void pendSvIsr(void); // Scheduler deferred tasks
+extern void latencyLoadIsr(void); // Latency test load
+extern void uart0Isr(void); // UART0 receive
+extern void buttonIsr(void); // Push buttons
+extern void faultIsr(void); // Watchdog NMI and faults, crash capture
 //extern void goStraightISR(void); // PID/goStraight
 
 
@@ -78,11 +80,11 @@ void (* const g_pfnVectors[])(void) =
     (void (*)(void))((uint32_t)&__STACK_TOP),
                                             // The initial stack pointer
     ResetISR,                               // The reset handler
-    NmiSR,                                  // The NMI handler
-    FaultISR,                               // The hard fault handler
-    IntDefaultHandler,                      // The MPU fault handler
-    IntDefaultHandler,                      // The bus fault handler
-    IntDefaultHandler,                      // The usage fault handler
+    faultIsr,                               // The NMI handler
+    faultIsr,                               // The hard fault handler
+    faultIsr,                               // The MPU fault handler
+    faultIsr,                               // The bus fault handler
+    faultIsr,                               // The usage fault handler
     0,                                      // Reserved
     0,                                      // Reserved
     0,                                      // Reserved
@@ -90,14 +92,14 @@ void (* const g_pfnVectors[])(void) =
     IntDefaultHandler,                      // SVCall handler
     IntDefaultHandler,                      // Debug monitor handler
     0,                                      // Reserved
-    IntDefaultHandler,                      // The PendSV handler
-    IntDefaultHandler,                      // The SysTick handler
+    pendSvIsr,                              // The PendSV handler
+    sysTickIsr,                             // The SysTick handler
     IntDefaultHandler,                      // GPIO Port A
     IntDefaultHandler,                      // GPIO Port B
     IntDefaultHandler,                      // GPIO Port C
     IntDefaultHandler,                      // GPIO Port D
     IntDefaultHandler,                      // GPIO Port E
-    IntDefaultHandler,                      // UART0 Rx and Tx
+    uart0Isr,                               // UART0 Rx and Tx
     IntDefaultHandler,                      // UART1 Rx and Tx
     IntDefaultHandler,                      // SSI0 Rx and Tx
     IntDefaultHandler,                      // I2C0 Master and Slave
@@ -111,19 +113,18 @@ void (* const g_pfnVectors[])(void) =
     IntDefaultHandler,                      // ADC Sequence 2
     IntDefaultHandler,                      // ADC Sequence 3
     IntDefaultHandler,                      // Watchdog timer
-    IntDefaultHandler,                      // Timer 0 subtimer A
+    latencyLoadIsr,                         // Timer 0 subtimer A
     IntDefaultHandler,                      // Timer 0 subtimer B
-    balancePID,                      // Timer 1 subtimer A
+    IntDefaultHandler,                      // Timer 1 subtimer A
     IntDefaultHandler,                      // Timer 1 subtimer B
-    pidISR,                      // Timer 2 subtimer A
-    //goStraightISR,                      // Timer 2 subtimer A
+    IntDefaultHandler,                      // Timer 2 subtimer A
     IntDefaultHandler,                      // Timer 2 subtimer B
     IntDefaultHandler,                      // Analog Comparator 0
     IntDefaultHandler,                      // Analog Comparator 1
     IntDefaultHandler,                      // Analog Comparator 2
     IntDefaultHandler,                      // System Control (PLL, OSC, BO)
     IntDefaultHandler,                      // FLASH Control
-    IntDefaultHandler,                      // GPIO Port F
+    buttonIsr,                              // GPIO Port F
     IntDefaultHandler,                      // GPIO Port G
     IntDefaultHandler,                      // GPIO Port H
     IntDefaultHandler,                      // UART2 Rx and Tx
@@ -255,42 +256,6 @@ ResetISR(void)
           "    b.w     _c_int00");
 }
 
-//*****************************************************************************
-//
-// This is the code that gets called when the processor receives a NMI.  This
-// simply enters an infinite loop, preserving the system state for examination
-// by a debugger.
-//
-//*****************************************************************************
-static void
-NmiSR(void)
-{
-    //
-    // Enter an infinite loop.
-    //
-    while(1)
-    {
-    }
-}
-
-//*****************************************************************************
-//
-// This is the code that gets called when the processor receives a fault
-// interrupt.  This simply enters an infinite loop, preserving the system state
-// for examination by a debugger.
-//
-//*****************************************************************************
-static void
-FaultISR(void)
-{
-    //
-    // Enter an infinite loop.
-    //
-    while(1)
-    {
-    }
-}
-
 //*****************************************************************************
 //
 // This is the code that gets called when the processor receives an unexpected
@@ -27,16 +27,87 @@
 #include <stdarg.h>
 #include "tm4c123gh6pm.h"
 #include "uart0.h"
-#include "conversion.h"
+#include "clock.h"
+#include "format.h"
 
 // PortA masks
 #define UART_TX_MASK 2
 #define UART_RX_MASK 1
 
+#define UART0_DEFAULT_BAUD 115200
+
+// Character classes of the tokenizer
+#define CLASS_DELIMITER 0
+#define CLASS_ALPHA     1
+#define CLASS_DIGIT     2
+#define CLASS_SIGN      3
+#define CLASS_POINT     4
+
+// Tokenizer states
+#define FIELD_NONE      0   // between fields
+#define FIELD_WORD      1
+#define FIELD_SIGN      2   // sign seen, digit or point next
+#define FIELD_INTEGER   3
+#define FIELD_FRACTION  4
+#define FIELD_UNIT      5
+
+#define FIELD_MAX_INTEGER  2147483647
+#define FIELD_MAX_DECIMALS 7        // as many as a float holds
+
+// Transmit goes through a ring buffer that the TX interrupt drains into the
+// FIFO, so printing costs a copy, not the time on the wire. The interrupt
+// fires when the FIFO drains past half, which is a transition, so writers
+// also top up the FIFO themselves and get the first bytes going.
+// A writer with more to send than fits arms the low-water hook and comes
+// back when the interrupt has drained the ring, instead of polling for room.
+// A full ring drops bytes, or waits for room in thread context if the policy
+// is UART0_TX_BLOCK. The wait drains the FIFO itself, so it also works with
+// interrupts masked. ISRs never wait.
+// Receive is the other way around: the RX interrupt empties the FIFO into a
+// ring and tells the hook, the main loop takes characters from the ring as it
+// gets to them. Characters with a framing, parity or break error are dropped,
+// they are what arrives while the two ends disagree on the baud rate.
+// The baud divisor is IBRD + FBRD/64 of the UART clock over 16, or over 8
+// with HSE. 16x sampling is used whenever it reaches the rate as closely,
+// since it rejects more noise. A rate whose error is over
+// UART0_BAUD_MAX_ERROR is refused and the UART keeps its old rate.
+
 //-----------------------------------------------------------------------------
 // Global variables
 //-----------------------------------------------------------------------------
 
+void (*uart0WaitHook)(void) = 0;
+void (*uart0RxHook)(void) = 0;
+void (*uart0TxLowHook)(void) = 0;
+volatile uint16_t uart0TxLowLevel = 0;             // queued bytes that call the low hook, 0 if not armed
+
+char uart0TxBuffer[UART0_TX_BUFFER_SIZE];
+volatile uint16_t uart0TxHead = 0;          // next slot to write
+volatile uint16_t uart0TxTail = 0;          // next slot to send
+Uart0TxPolicy uart0TxPolicy = UART0_TX_BLOCK;
+
+char uart0RxBuffer[UART0_RX_BUFFER_SIZE];
+volatile uint16_t uart0RxHead = 0;          // written by the ISR only
+volatile uint16_t uart0RxTail = 0;          // written by the reader only
+
+UART0_STATS uart0Stats;
+
+// ASCII to CLASS_, one lookup per character instead of range tests
+const uint8_t fieldClass[128] =
+{
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,     // control
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 3, 0, 3, 4, 0,     //  !"#$%&'()*+,-./
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 0, 0, 0, 0, 0, 0,     // 0-9 :;<=>?
+    0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,     // @A-O
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0,     // P-Z [\]^_
+    0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,     // `a-o
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 0, 0, 0, 0, 0      // p-z {|}~ DEL
+};
+
+const uint32_t fieldPow10[FIELD_MAX_DECIMALS + 1] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000 };
+UART0_BAUD uart0Baud;
+
 //-----------------------------------------------------------------------------
 // Subroutines
 //-----------------------------------------------------------------------------
@@ -59,36 +130,292 @@ void initUart0()
 
     // Configure UART0 to 115200 baud, 8N1 format
     UART0_CTL_R = 0;                                    // turn-off UART0 to allow safe programming
-    UART0_CC_R = UART_CC_CS_SYSCLK;                     // use system clock (40 MHz)
-    UART0_IBRD_R = 21;                                  // r = 40 MHz / (Nx115.2kHz), set floor(r)=21, where N=16
-    UART0_FBRD_R = 45;                                  // round(fract(r)*64)=45
+    UART0_CC_R = UART_CC_CS_SYSCLK;                     // use system clock (SYSTEM_CLOCK_HZ)
+    getUart0BaudDivisor(UART0_DEFAULT_BAUD, SYSTEM_CLOCK_HZ, &uart0Baud);
+    UART0_IBRD_R = uart0Baud.ibrd;                      // r = fcyc / (Nx115.2kHz), set floor(r), where N=16
+    UART0_FBRD_R = uart0Baud.fbrd;                      // round(fract(r)*64)
     UART0_LCRH_R = UART_LCRH_WLEN_8 | UART_LCRH_FEN;    // configure for 8N1 w/ 16-level FIFO
+    UART0_IFLS_R = UART_IFLS_TX4_8 | UART_IFLS_RX4_8;   // TX interrupt when the FIFO drains to half
     UART0_CTL_R = UART_CTL_TXE | UART_CTL_RXE | UART_CTL_UARTEN;
                                                         // enable TX, RX, and module
+
+    // Only the TX interrupt is unmasked for now, its level comes from initPriorities()
+    uart0TxHead = 0;
+    uart0TxTail = 0;
+    uart0RxHead = 0;
+    uart0RxTail = 0;
+    uart0Stats.txDropped = 0;
+    uart0Stats.txMaxQueued = 0;
+    uart0Stats.rxDropped = 0;
+    uart0Stats.rxErrors = 0;
+    NVIC_EN0_R = 1 << (INT_UART0-16);
+}
+
+// Called repeatedly while getcUart0() waits for a character
+void setUart0WaitHook(void (*hook)(void))
+{
+    uart0WaitHook = hook;
+}
+
+// Called from the UART0 ISR when characters were added to the receive ring
+void setUart0RxHook(void (*hook)(void))
+{
+    uart0RxHook = hook;
+}
+
+// Called once from the UART0 ISR per armUart0TxLow(), when the transmit ring has drained
+void setUart0TxLowHook(void (*hook)(void))
+{
+    uart0TxLowHook = hook;
+}
+
+// Arms the low hook for when level bytes or fewer are queued, level > 0
+// Returns false if that is already the case, the hook isn't called then
+bool armUart0TxLow(uint16_t level)
+{
+    uint32_t primask = _disable_interrupts();
+    bool armed = (uint16_t)(uart0TxHead - uart0TxTail) > level;
+
+    uart0TxLowLevel = armed ? level : 0;
+    _restore_interrupts(primask);
+    return armed;
+}
+
+// Receive interrupt on, once the hook is set
+void enableUart0RxInterrupt(void)
+{
+    uint32_t primask = _disable_interrupts();       // the TX side changes IM from the ISR
+    UART0_ICR_R = UART_ICR_RXIC;
+    UART0_IM_R |= UART_IM_RXIM | UART_IM_RTIM;
+    _restore_interrupts(primask);
+}
+
+// Divisor for one sampling rate, fills baud and returns the error's magnitude
+uint32_t fitUart0Divisor(uint32_t baudRate, uint32_t fcyc, bool highSpeed, UART0_BAUD* baud)
+{
+    uint8_t samples = highSpeed ? 8 : 16;
+    uint64_t divisorTimes64 = (((uint64_t)fcyc * 128) / ((uint64_t)samples * baudRate) + 1) / 2;
+                                                        // r = fcyc / (N * baudRate) in units of 1/64, rounded
+    int64_t error;
+
+    if (divisorTimes64 < 64)
+        divisorTimes64 = 64;                            // IBRD can't be 0
+    if (divisorTimes64 > 0x3FFFFF)
+        divisorTimes64 = 0x3FFFFF;                      // IBRD is 16 bits
+
+    baud->requested = baudRate;
+    baud->actual = ((uint64_t)fcyc * 64 + (samples * divisorTimes64) / 2) / (samples * divisorTimes64);
+    baud->ibrd = divisorTimes64 >> 6;
+    baud->fbrd = divisorTimes64 & 63;
+    baud->highSpeed = highSpeed;
+    error = ((int64_t)baud->actual - baudRate) * 10000 / baudRate;
+    baud->error = (error > 32767) ? 32767 : (error < -32767) ? -32767 : error;
+    return (error < 0) ? -error : error;
+}
+
+// Fills baud with the closest divisor and its error in 0.01 %
+// Returns false if even the closest is out of tolerance
+bool getUart0BaudDivisor(uint32_t baudRate, uint32_t fcyc, UART0_BAUD* baud)
+{
+    UART0_BAUD fast;
+    uint32_t error;
+
+    if (baudRate == 0)
+        return false;
+
+    error = fitUart0Divisor(baudRate, fcyc, false, baud);
+    if (fitUart0Divisor(baudRate, fcyc, true, &fast) < error)
+    {
+        *baud = fast;
+        error = (baud->error < 0) ? -baud->error : baud->error;
+    }
+    return error <= UART0_BAUD_MAX_ERROR;
 }
 
 // Set baud rate as function of instruction cycle frequency
-void setUart0BaudRate(uint32_t baudRate, uint32_t fcyc)
+// Returns false and keeps the current rate if it can't be reached within tolerance
+bool setUart0BaudRate(uint32_t baudRate, uint32_t fcyc)
 {
-    uint32_t divisorTimes128 = (fcyc * 8) / baudRate;   // calculate divisor (r) in units of 1/128,
-                                                        // where r = fcyc / 16 * baudRate
-    divisorTimes128 += 1;                               // add 1/128 to allow rounding
+    UART0_BAUD baud;
+
+    if (!getUart0BaudDivisor(baudRate, fcyc, &baud))
+        return false;
+
+    flushUart0();                                       // don't cut off what is still queued
     UART0_CTL_R = 0;                                    // turn-off UART0 to allow safe programming
-    UART0_IBRD_R = divisorTimes128 >> 7;                // set integer value to floor(r)
-    UART0_FBRD_R = ((divisorTimes128) >> 1) & 63;       // set fractional value to round(fract(r)*64)
-    UART0_LCRH_R = UART_LCRH_WLEN_8 | UART_LCRH_FEN;    // configure for 8N1 w/ 16-level FIFO
-    UART0_CTL_R = UART_CTL_TXE | UART_CTL_RXE | UART_CTL_UARTEN;
+    UART0_IBRD_R = baud.ibrd;                           // set integer value to floor(r)
+    UART0_FBRD_R = baud.fbrd;                           // set fractional value to round(fract(r)*64)
+    UART0_LCRH_R = UART_LCRH_WLEN_8 | UART_LCRH_FEN;    // configure for 8N1 w/ 16-level FIFO, latches the divisor
+    UART0_CTL_R = UART_CTL_TXE | UART_CTL_RXE | UART_CTL_UARTEN | (baud.highSpeed ? UART_CTL_HSE : 0);
                                                         // turn-on UART0
+    uart0Baud = baud;
+    return true;
 }
 
-// Blocking function that writes a serial character when the UART buffer is not full
+// The rate in use, with the divisor and its error
+UART0_BAUD getUart0Baud(void)
+{
+    return uart0Baud;
+}
+
+// Moves queued bytes into the FIFO until it is full, interrupts masked by the caller
+void pumpUart0Tx(void)
+{
+    uint16_t tail = uart0TxTail;
+
+    while ((tail != uart0TxHead) && !(UART0_FR_R & UART_FR_TXFF))
+    {
+        UART0_DR_R = uart0TxBuffer[tail % UART0_TX_BUFFER_SIZE];
+        tail++;
+    }
+    uart0TxTail = tail;
+
+    // Ask for a refill only while something is left
+    if (tail != uart0TxHead)
+        UART0_IM_R |= UART_IM_TXIM;
+    else
+        UART0_IM_R &= ~UART_IM_TXIM;
+}
+
+bool inThreadMode(void)
+{
+    return (NVIC_INT_CTRL_R & NVIC_INT_CTRL_VEC_ACT_M) == 0;
+}
+
+// Queues a character, returns in microseconds unless the ring is full and
+// the policy says to wait
 void putcUart0(char c)
 {
-    while (UART0_FR_R & UART_FR_TXFF);               // wait if uart0 tx fifo full
-    UART0_DR_R = c;                                  // write character to fifo
+    uint32_t primask;
+    uint16_t queued;
+
+    while (true)
+    {
+        primask = _disable_interrupts();            // compiler intrinsic, returns the old PRIMASK
+        queued = uart0TxHead - uart0TxTail;
+        if (queued < UART0_TX_BUFFER_SIZE)
+            break;
+        if ((uart0TxPolicy == UART0_TX_DROP) || !inThreadMode())
+        {
+            uart0Stats.txDropped++;
+            _restore_interrupts(primask);
+            return;
+        }
+        // Wait with interrupts open so the tick isn't held off, unless the
+        // caller masked them, then nobody else will drain the ring
+        if (primask != 0)
+            pumpUart0Tx();
+        _restore_interrupts(primask);
+    }
+
+    uart0TxBuffer[uart0TxHead % UART0_TX_BUFFER_SIZE] = c;
+    uart0TxHead++;
+    if (queued + 1 > uart0Stats.txMaxQueued)
+        uart0Stats.txMaxQueued = queued + 1;
+    pumpUart0Tx();
+    _restore_interrupts(primask);
+}
+
+// Queues length bytes in one piece or, if the ring hasn't room for all of
+// them, none. Never waits, for binary packets from any context
+bool writeUart0(const char* data, uint16_t length)
+{
+    uint32_t primask = _disable_interrupts();
+    uint16_t queued = uart0TxHead - uart0TxTail;
+    uint16_t i;
+
+    if (UART0_TX_BUFFER_SIZE - queued < length)
+    {
+        _restore_interrupts(primask);
+        return false;
+    }
+    for (i = 0; i < length; i++)
+        uart0TxBuffer[(uart0TxHead + i) % UART0_TX_BUFFER_SIZE] = data[i];
+    uart0TxHead += length;
+    if (queued + length > uart0Stats.txMaxQueued)
+        uart0Stats.txMaxQueued = queued + length;
+    pumpUart0Tx();
+    _restore_interrupts(primask);
+    return true;
+}
+
+// Waits until everything queued has left the UART, thread context only
+void flushUart0(void)
+{
+    uint32_t primask;
+
+    do
+    {
+        primask = _disable_interrupts();
+        pumpUart0Tx();
+        _restore_interrupts(primask);
+    }
+    while (uart0TxTail != uart0TxHead);
+    while (UART0_FR_R & UART_FR_BUSY);
+}
+
+void setUart0TxPolicy(Uart0TxPolicy policy)
+{
+    uart0TxPolicy = policy;
+}
+
+UART0_STATS getUart0Stats(void)
+{
+    return uart0Stats;
 }
 
-// Blocking function that writes a string when the UART buffer is not full
+uint16_t getUart0TxQueued(void)
+{
+    return uart0TxHead - uart0TxTail;
+}
+
+// Transmit refills from the ring, receive empties the FIFO into the other one
+void uart0Isr(void)
+{
+    uint16_t head;
+    uint32_t data;
+    bool received = false;
+
+    if (UART0_MIS_R & UART_MIS_TXMIS)
+    {
+        UART0_ICR_R = UART_ICR_TXIC;
+        pumpUart0Tx();
+        if (uart0TxLowLevel != 0 && (uint16_t)(uart0TxHead - uart0TxTail) <= uart0TxLowLevel)
+        {
+            uart0TxLowLevel = 0;
+            if (uart0TxLowHook != 0)
+                uart0TxLowHook();
+        }
+    }
+    if (UART0_MIS_R & (UART_MIS_RXMIS | UART_MIS_RTMIS))
+    {
+        UART0_ICR_R = UART_ICR_RXIC | UART_ICR_RTIC;
+        head = uart0RxHead;
+        while (!(UART0_FR_R & UART_FR_RXFE))
+        {
+            data = UART0_DR_R;
+            if (data & (UART_DR_FE | UART_DR_PE | UART_DR_BE))
+            {
+                uart0Stats.rxErrors++;
+            }
+            else if ((uint16_t)(head - uart0RxTail) < UART0_RX_BUFFER_SIZE)
+            {
+                uart0RxBuffer[head % UART0_RX_BUFFER_SIZE] = data & 0xFF;
+                head++;
+                received = true;
+            }
+            else
+            {
+                uart0Stats.rxDropped++;
+            }
+        }
+        uart0RxHead = head;
+        if (received && uart0RxHook != 0)
+            uart0RxHook();
+    }
+}
+
+// Writes a string through the transmit ring
 void putsUart0(char* str)
 {
     uint8_t i = 0;
@@ -96,17 +423,25 @@ void putsUart0(char* str)
         putcUart0(str[i++]);
 }
 
-// Blocking function that returns with serial data once the buffer is not empty
+// Blocking function that returns with serial data once the receive ring is not empty
 char getcUart0()
 {
-    while (UART0_FR_R & UART_FR_RXFE);               // wait if uart0 rx fifo empty
-    return UART0_DR_R & 0xFF;                        // get character from fifo
+    char c;
+
+    while (uart0RxTail == uart0RxHead)               // wait if the ring is empty
+    {
+        if (uart0WaitHook != 0)
+            uart0WaitHook();                         // waiting for a person is not a hang
+    }
+    c = uart0RxBuffer[uart0RxTail % UART0_RX_BUFFER_SIZE];
+    uart0RxTail++;
+    return c;
 }
 
-// Returns the status of the receive buffer
+// Returns the status of the receive ring
 bool kbhitUart0()
 {
-    return !(UART0_FR_R & UART_FR_RXFE);
+    return uart0RxTail != uart0RxHead;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------
@@ -185,75 +520,187 @@ void getsUart0(USER_DATA* data)
 
 //------------------------------------------------------------------------------------------------------------------------------------
 
-// Alpha is a-z and A-Z, numeric is 0-9 and optionally hyphen and period (or comma in some localizations), and everything else is a delimiter
-// Alpha a-z (97-122), A-Z (65-90), numeric (48-57)
-// Delimiter (1-47) (58-64) (91-96) (123-127)
+uint8_t getCharClass(char c)
+{
+    return ((uint8_t)c < 128) ? fieldClass[(uint8_t)c] : CLASS_DELIMITER;
+}
+
+// Unit suffix of a number, UNIT_NONE if it isn't one
+uint8_t findUnit(const char* unit, uint8_t length)
+{
+    if (length == 2 && unit[0] == 'c' && unit[1] == 'm')
+        return UNIT_CM;
+    if (length == 1 && unit[0] == 'm')
+        return UNIT_M;
+    if (length == 3 && unit[0] == 'd' && unit[1] == 'e' && unit[2] == 'g')
+        return UNIT_DEG;
+    return UNIT_NONE;
+}
+
+// Splits the line into fields in one pass, ending each field with '\0' in place
+// Letters start a word ('a'), which runs to the next delimiter. Digits, or a
+// sign or point before a digit, start a number: 'n' for an integer, 'd' with
+// a decimal point, optionally followed by a unit (cm, m, deg). The value goes
+// into fieldInteger and fieldNumber as it is scanned. A number that runs into
+// anything else, or an unknown unit, is taken as a word.
+// Delimiters are everything that isn't a letter, digit, sign or point
 void parseFields(USER_DATA* data)
 {
     uint32_t i = 0;
     uint32_t count = 0;
+    uint8_t state = FIELD_NONE;
+    uint8_t class;
+    uint8_t next;
+    uint8_t unitStart = 0;
+    uint8_t fractionDigits = 0;
+    uint32_t fraction = 0;
+    uint32_t integer = 0;
+    bool negative = false;
+    bool decimal = false;
+    char c;
 
-    uint32_t d, a, n;
-
-    while(true)
+    data->fieldCount = 0;
+    while (true)
     {
-        d = ((data->buffer[i] >= 1 && data->buffer[i] <= 47) || (data->buffer[i] >= 58 && data->buffer[i] <= 64) || (data->buffer[i] >= 91 && data->buffer[i] <= 96) || (data->buffer[i] >= 123 && data->buffer[i] <= 127));
-        a = ((data->buffer[i] >= 97 && data->buffer[i] <= 122) || (data->buffer[i] >= 65 && data->buffer[i] <= 90));
-        n = (data->buffer[i] >= 48 && data->buffer[i] <= 57);
+        c = data->buffer[i];
+        class = getCharClass(c);
 
-        if (d)
+        if (state == FIELD_NONE)
         {
-            if((data->buffer[i-1] >= 1 && data->buffer[i-1] <= 47) || (data->buffer[i-1] >= 58 && data->buffer[i-1] <= 64) || (data->buffer[i-1] >= 91 && data->buffer[i-1] <= 96) || (data->buffer[i-1] >= 123 && data->buffer[i-1] <= 127))
+            if (c == '\0' || count == MAX_FIELDS)
+                break;
+            if (class == CLASS_DELIMITER)
             {
-                //data->buffer[i-1] = '\0';
+                i++;
+                continue;
             }
 
-            i++;
-
-            if(data->buffer[i] == '\0')
+            // A sign or point only starts a number when a digit follows (or a point then a digit)
+            next = getCharClass(data->buffer[i + 1]);
+            data->fieldPosition[count] = i;
+            data->fieldUnit[count] = UNIT_NONE;
+            integer = 0;
+            fraction = 0;
+            fractionDigits = 0;
+            negative = (c == '-');
+            decimal = (class == CLASS_POINT);
+            if (class == CLASS_DIGIT)
             {
-                data->fieldCount = count;
-                putsUart0("\n");
-                break;
+                state = FIELD_INTEGER;
+                integer = c - '0';
             }
-            //continue;
-        }
-
-        if(a || n)
-        {
-            if(a)
+            else if (class == CLASS_POINT && next == CLASS_DIGIT)
             {
-                data->fieldType[count] = 'a';
+                state = FIELD_FRACTION;
             }
-
-            else if(n)
+            else if (class == CLASS_SIGN && (next == CLASS_DIGIT
+                     || (next == CLASS_POINT && getCharClass(data->buffer[i + 2]) == CLASS_DIGIT)))
             {
-                data->fieldType[count] = 'n';
+                state = FIELD_SIGN;
             }
-
-            data->fieldPosition[count] = i;
-
-            if(((data->buffer[i-1] >= 1 && data->buffer[i-1] <= 47) || (data->buffer[i-1] >= 58 && data->buffer[i-1] <= 64) || (data->buffer[i-1] >= 91 && data->buffer[i-1] <= 96) || (data->buffer[i-1] >= 123 && data->buffer[i-1] <= 127)) && (a || n))
+            else
             {
-                //data->buffer[i-1] = '\0';
-                count++;
+                state = FIELD_WORD;
             }
+            i++;
+            continue;
+        }
 
-            if (i == 0)
+        // End of a field
+        if (class == CLASS_DELIMITER)
+        {
+            if (state == FIELD_UNIT)
             {
-                count++;
+                data->fieldUnit[count] = findUnit(&data->buffer[unitStart], i - unitStart);
+                if (data->fieldUnit[count] == UNIT_NONE)
+                    state = FIELD_WORD;
             }
-
-            i++;
-
-            if(data->buffer[i] == '\0' || count == MAX_FIELDS)
+            if (state == FIELD_WORD)
             {
-                data->fieldCount = count;
-                putsUart0("\n");
-                break;
+                data->fieldType[count] = 'a';
+                data->fieldInteger[count] = 0;
+                data->fieldNumber[count] = 0;
+            }
+            else
+            {
+                data->fieldType[count] = decimal ? 'd' : 'n';
+                data->fieldInteger[count] = negative ? -(int32_t)integer : (int32_t)integer;
+                data->fieldNumber[count] = integer + (float)fraction / fieldPow10[fractionDigits];
+                if (negative)
+                    data->fieldNumber[count] = -data->fieldNumber[count];
             }
+            count++;
+            state = FIELD_NONE;
+            if (c == '\0')
+                break;
+            data->buffer[i++] = '\0';
+            continue;
+        }
+
+        switch (state)
+        {
+            case FIELD_SIGN:
+                if (class == CLASS_DIGIT)
+                {
+                    state = FIELD_INTEGER;
+                    integer = c - '0';
+                }
+                else
+                {
+                    state = FIELD_FRACTION;
+                    decimal = true;
+                }
+                break;
+            case FIELD_INTEGER:
+                if (class == CLASS_DIGIT)
+                {
+                    integer = (integer < FIELD_MAX_INTEGER / 10) ? integer * 10 + (c - '0') : FIELD_MAX_INTEGER;
+                }
+                else if (class == CLASS_POINT)
+                {
+                    state = FIELD_FRACTION;
+                    decimal = true;
+                }
+                else if (class == CLASS_ALPHA)
+                {
+                    state = FIELD_UNIT;
+                    unitStart = i;
+                }
+                else
+                {
+                    state = FIELD_WORD;
+                }
+                break;
+            case FIELD_FRACTION:
+                if (class == CLASS_DIGIT)
+                {
+                    // Digits past what a float holds are dropped
+                    if (fractionDigits < FIELD_MAX_DECIMALS)
+                    {
+                        fraction = fraction * 10 + (c - '0');
+                        fractionDigits++;
+                    }
+                }
+                else if (class == CLASS_ALPHA)
+                {
+                    state = FIELD_UNIT;
+                    unitStart = i;
+                }
+                else
+                {
+                    state = FIELD_WORD;
+                }
+                break;
+            case FIELD_UNIT:
+                if (class != CLASS_ALPHA)
+                    state = FIELD_WORD;
+                break;
+            default:
+                break;
         }
+        i++;
     }
+    data->fieldCount = count;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------
@@ -286,9 +733,10 @@ char* getFieldString(USER_DATA* data, uint32_t fieldNumber)
 
 //------------------------------------------------------------------------------------------------------------------------------------
 
+// Numbers only, decimals are truncated
 int32_t getFieldInteger(USER_DATA* data, uint32_t fieldNumber)
 {
-    return atoi(getFieldString(data, fieldNumber));
+    return data->fieldInteger[fieldNumber];
 }
 
 
@@ -296,7 +744,18 @@ int32_t getFieldInteger(USER_DATA* data, uint32_t fieldNumber)
 
 double getFieldDouble(USER_DATA* data, uint32_t fieldNumber)
 {
-    return atof(getFieldString(data, fieldNumber));
+    return data->fieldNumber[fieldNumber];
+}
+
+float getFieldNumber(USER_DATA* data, uint32_t fieldNumber)
+{
+    return data->fieldNumber[fieldNumber];
+}
+
+// UNIT_ suffix of a number field
+uint8_t getFieldUnit(USER_DATA* data, uint32_t fieldNumber)
+{
+    return data->fieldUnit[fieldNumber];
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------
@@ -311,74 +770,18 @@ bool  isCommand(USER_DATA* data, const char strCommand[], uint32_t minArguments)
     return false;
 }
 
-void printfUart0(char* format, ...)
+// formatOutput() sink
+void putcUart0Format(char c, void* context)
 {
-    char *traverse;
-    int input;
-    double inputFloat;
-
-    char* returnStr;
-
-    va_list arg;
-    va_start(arg, format);
-
-    for(traverse = format; *traverse != '\0'; traverse++)
-    {
-        while( *traverse != '%' )
-        {
-            if( *traverse == '\0')
-            {
-                return;
-            }
-            else
-            {
-                putcUart0(*traverse);
-                traverse++;
-            }
-        }
-
-        traverse++;
+    putcUart0(c);
+}
 
-        switch(*traverse)
-        {
-            // CHAR
-            case 'c' :
-                input = va_arg(arg,char);     //Fetch char argument
-                putcUart0(input);
-                break;
-            // HEX LOWER CASE
-            case 'x':
-                input = va_arg(arg,uint32_t);
-                putsUart0(uint32_to_strhex(input, LOWERCASE));
-                break;
-            // HEX UPPER CASE
-            case 'X':
-                input = va_arg(arg,uint32_t);
-                putsUart0(uint32_to_strhex(input, UPPERCASE));
-                break;
-            // INT
-            case 'd':
-                input = va_arg(arg, int);
-                putsUart0(int_to_str(input));
-                break;
-            // UNSIGNED INT
-            case 'u':
-                input = va_arg(arg, uint32_t);
-                putsUart0(uint_to_str(input));
-                break;
-            // STRING
-            case 's':
-                input = va_arg(arg, char*);
-                putsUart0(input);
-                break;
-            // 32 BIT FLOAT
-            case 'f':
-                input = va_arg(arg, int*);
-                putsUart0(float_to_str(input));
-                break;
-        }
-    }
+// printf through format.c, %f takes float values, not pointers
+void printfUart0(char* format, ...)
+{
+    va_list args;
 
-    //Module 3: Closing argument list to necessary clean-up
-    va_end(arg);
-}
\ No newline at end of file
+    va_start(args, format);
+    formatOutput(putcUart0Format, 0, format, args);
+    va_end(args);
+}
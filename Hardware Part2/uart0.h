@@ -25,13 +25,52 @@
 #define MAX_CHARS 80
 #define MAX_FIELDS 5
 
+#define UART0_TX_BUFFER_SIZE 512    // power of two, about 44 ms of output at 115200 baud
+#define UART0_RX_BUFFER_SIZE 128    // power of two
+#define UART0_BAUD_MAX_ERROR 150    // 0.01 %, leaves the host about as much again out of a ~3 % budget
+
 // Structs
+typedef enum
+{
+    UART0_TX_BLOCK,     // a full ring waits for room in thread context, ISRs drop
+    UART0_TX_DROP       // a full ring always drops
+} Uart0TxPolicy;
+
+typedef struct _UART0_STATS
+{
+    uint32_t txDropped;     // bytes lost to a full transmit ring
+    uint16_t txMaxQueued;   // deepest the transmit ring has been
+    uint32_t rxDropped;     // bytes received while the receive ring was full
+    uint32_t rxErrors;      // bytes dropped on a framing, parity or break error
+} UART0_STATS;
+
+typedef struct _UART0_BAUD
+{
+    uint32_t requested;
+    uint32_t actual;        // what the divisor gives
+    int16_t error;          // (actual - requested) in 0.01 %
+    bool highSpeed;         // HSE, 8x instead of 16x sampling
+    uint16_t ibrd;
+    uint8_t fbrd;
+} UART0_BAUD;
+
+typedef enum
+{
+    UNIT_NONE,
+    UNIT_CM,
+    UNIT_M,
+    UNIT_DEG
+} FieldUnit;
+
 typedef struct _USER_DATA
 {
     char buffer[MAX_CHARS + 1];
     uint32_t fieldCount;
     uint32_t fieldPosition[MAX_FIELDS];
-    char fieldType[MAX_FIELDS];
+    char fieldType[MAX_FIELDS];         // 'a' word, 'n' integer, 'd' decimal
+    int32_t fieldInteger[MAX_FIELDS];   // value of a number, decimals truncated
+    float fieldNumber[MAX_FIELDS];
+    uint8_t fieldUnit[MAX_FIELDS];      // FieldUnit suffix of a number
 } USER_DATA;
 
 //-----------------------------------------------------------------------------
@@ -39,8 +78,21 @@ typedef struct _USER_DATA
 //-----------------------------------------------------------------------------
 
 void initUart0();
-void setUart0BaudRate(uint32_t baudRate, uint32_t fcyc);
+bool getUart0BaudDivisor(uint32_t baudRate, uint32_t fcyc, UART0_BAUD* baud);
+bool setUart0BaudRate(uint32_t baudRate, uint32_t fcyc);
+UART0_BAUD getUart0Baud(void);
+void setUart0WaitHook(void (*hook)(void));
+void setUart0RxHook(void (*hook)(void));
+void setUart0TxLowHook(void (*hook)(void));
+bool armUart0TxLow(uint16_t level);
+void enableUart0RxInterrupt(void);
+void uart0Isr(void);
 void putcUart0(char c);
+bool writeUart0(const char* data, uint16_t length);
+void flushUart0(void);
+void setUart0TxPolicy(Uart0TxPolicy policy);
+UART0_STATS getUart0Stats(void);
+uint16_t getUart0TxQueued(void);
 void putsUart0(char* str);
 char getcUart0();
 bool kbhitUart0();
@@ -52,6 +104,8 @@ bool customStrcmp (const char strCommand[], const char argument[]);
 char* getFieldString(USER_DATA* data, uint32_t fieldNumber);
 int32_t getFieldInteger(USER_DATA* data, uint32_t fieldNumber);
 double getFieldDouble(USER_DATA* data, uint32_t fieldNumber);
+float getFieldNumber(USER_DATA* data, uint32_t fieldNumber);
+uint8_t getFieldUnit(USER_DATA* data, uint32_t fieldNumber);
 bool  isCommand(USER_DATA* data, const char strCommand[], uint32_t minArguments);
 void printfUart0(char* format, ...);
 
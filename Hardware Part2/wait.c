@@ -6,7 +6,7 @@
 //-----------------------------------------------------------------------------
 
 // Target uC:       TM4C123GH6PM
-// System Clock:    40 MHz
+// System Clock:    80 MHz
 
 //-----------------------------------------------------------------------------
 // Device includes, defines, and assembler directives
@@ -15,16 +15,24 @@
 #include <stdint.h>
 #include "tm4c123gh6pm.h"
 #include "wait.h"
+#include "clock.h"
 
 //-----------------------------------------------------------------------------
 // Subroutines
 //-----------------------------------------------------------------------------
 
-// Approximate busy waiting (in units of microseconds), given a 40 MHz system clock
+// Approximate busy waiting (in units of microseconds), given the SYSTEM_CLOCK_HZ system clock
+// Each extra pass of the inner loop adds 6 clocks
 void waitMicrosecond(uint32_t us)
 {
 	                                            // Approx clocks per us
+#if SYSTEM_CLOCK_MHZ == 80
+	__asm("WMS_LOOP0:   MOV  R1, #13");         // 1 (82 clocks/us)
+#elif SYSTEM_CLOCK_MHZ == 16
+	__asm("WMS_LOOP0:   MOV  R1, #2");          // 1 (16 clocks/us)
+#else
 	__asm("WMS_LOOP0:   MOV  R1, #6");          // 1
+#endif
     __asm("WMS_LOOP1:   SUB  R1, #1");          // 6
     __asm("             CBZ  R1, WMS_DONE1");   // 5+1*3
     __asm("             NOP");                  // 5
@@ -6,7 +6,7 @@
 //-----------------------------------------------------------------------------
 
 // Target uC:       TM4C123GH6PM
-// System Clock:    40 MHz
+// System Clock:    80 MHz
 
 #ifndef WAIT_H_
 #define WAIT_H_
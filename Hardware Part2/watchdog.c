@@ -0,0 +1,110 @@
+// Watchdog Library
+// Xavier
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    80 MHz
+
+// Hardware configuration:
+// Watchdog timer 0 on the system clock, NMI on the first timeout
+
+// Each critical task checks in with one store to a bit-band alias, so the
+// check-in is atomic and costs the hot path nothing. serviceWatchdog() is a
+// low priority scheduler task that reloads the watchdog only when every
+// critical task has checked in since the last reload. A task that hangs, or
+// a higher priority ISR that never returns, stops the reloads.
+// The timeout is an NMI, so it gets through whatever is stuck. The NMI goes
+// to the fault handler in crash.c, which cuts the motors, records which tasks
+// went missing along with the rest of the crash, and resets. The next boot
+// reports it.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "tm4c123gh6pm.h"
+#include "watchdog.h"
+#include "clock.h"
+#include "uart0.h"
+
+// Bit-band alias of bit b of the word at a (SRAM)
+#define BITBAND_SRAM(a, b) (*((volatile uint32_t *)(0x22000000 + ((uint32_t)(a) - 0x20000000) * 32 + (b) * 4)))
+
+//-----------------------------------------------------------------------------
+// Global variables
+//-----------------------------------------------------------------------------
+
+volatile uint32_t watchdogCheckins = 0;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+// Start once the control loops run, it can't be stopped again
+void initWatchdog(void)
+{
+    SYSCTL_RCGCWD_R |= SYSCTL_RCGCWD_R0;
+    _delay_cycles(3);
+
+    watchdogCheckins = 0;
+
+    WATCHDOG0_LOCK_R = WDT_LOCK_UNLOCK;
+    WATCHDOG0_LOAD_R = (SYSTEM_CLOCK_HZ / 1000) * WATCHDOG_TIMEOUT_MS;
+    WATCHDOG0_TEST_R |= WDT_TEST_STALL;              // hold while the debugger has the core halted
+    WATCHDOG0_CTL_R = WDT_CTL_INTTYPE | WDT_CTL_RESEN; // NMI, reset on the second timeout as a backstop
+    WATCHDOG0_CTL_R |= WDT_CTL_INTEN;                // start counting
+    WATCHDOG0_LOCK_R = 0;
+}
+
+void watchdogCheckIn(uint8_t task)
+{
+    BITBAND_SRAM(&watchdogCheckins, task) = 1;
+}
+
+// Unconditional reload, for the few places that legitimately stop the tasks
+void feedWatchdog(void)
+{
+    WATCHDOG0_LOCK_R = WDT_LOCK_UNLOCK;
+    WATCHDOG0_LOAD_R = (SYSTEM_CLOCK_HZ / 1000) * WATCHDOG_TIMEOUT_MS;
+    WATCHDOG0_LOCK_R = 0;
+}
+
+// Scheduler task, well inside the timeout
+void serviceWatchdog(void)
+{
+    if ((watchdogCheckins & WATCHDOG_ALL) != WATCHDOG_ALL)
+        return;
+
+    BITBAND_SRAM(&watchdogCheckins, WATCHDOG_BALANCE) = 0;
+    BITBAND_SRAM(&watchdogCheckins, WATCHDOG_STRAIGHT) = 0;
+    BITBAND_SRAM(&watchdogCheckins, WATCHDOG_MAIN) = 0;
+    feedWatchdog();
+}
+
+// Check-in bits absent since the last feed, read by the fault handler on the NMI
+uint8_t getMissingCheckins(void)
+{
+    return ~watchdogCheckins & WATCHDOG_ALL;
+}
+
+// Called once at boot after UART0 is up, returns the cause bits it cleared
+uint32_t reportResetCause(void)
+{
+    uint32_t cause = SYSCTL_RESC_R;
+    SYSCTL_RESC_R = 0;
+
+    printfUart0("Reset cause:");
+    if (cause & SYSCTL_RESC_POR) printfUart0(" power-on");
+    if (cause & SYSCTL_RESC_BOR) printfUart0(" brown-out");
+    if (cause & SYSCTL_RESC_EXT) printfUart0(" reset-pin");
+    if (cause & SYSCTL_RESC_WDT0) printfUart0(" watchdog");
+    if (cause & SYSCTL_RESC_SW) printfUart0(" software");
+    printfUart0("\n");
+    return cause;
+}
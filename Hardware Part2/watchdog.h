@@ -0,0 +1,45 @@
+// Watchdog Library
+// Xavier
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    80 MHz
+
+// Hardware configuration:
+// Watchdog timer 0 on the system clock, NMI on the first timeout
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef WATCHDOG_H_
+#define WATCHDOG_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// General Defines
+#define WATCHDOG_TIMEOUT_MS     1000    // no feed for this long and the motors are cut
+
+// Critical tasks, each must check in between two feeds
+#define WATCHDOG_BALANCE        0
+#define WATCHDOG_STRAIGHT       1
+#define WATCHDOG_MAIN           2
+#define WATCHDOG_ALL            ((1 << WATCHDOG_BALANCE) | (1 << WATCHDOG_STRAIGHT) | (1 << WATCHDOG_MAIN))
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initWatchdog(void);
+void watchdogCheckIn(uint8_t task);
+void feedWatchdog(void);
+void serviceWatchdog(void);
+uint8_t getMissingCheckins(void);
+uint32_t reportResetCause(void);
+
+#endif
@@ -0,0 +1,123 @@
+// Wheel Speed Library
+// Xavier
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    80 MHz
+
+// Hardware configuration:
+// OPB876N55 optical interrupters on WT1CCP0 (left) and WT5CCP0 (right),
+// wide timers in 32-bit edge-time capture mode counting up
+
+// Speed is estimated with the M/T method: each control period counts the
+// edges that arrived (M) and divides by the exact time between the first and
+// last of those edges (T), both taken from the capture register. At low speed
+// this acts like a period measurement, at high speed like an edge count, and
+// the result never depends on where the control tick fell between two tabs.
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "wheelSpeed.h"
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initWheelSpeed(WHEEL_SPEED* wheel)
+{
+    wheel->edgeCount = 0;
+    wheel->lastEdgeTime = 0;
+    wheel->lastPeriod = 0;
+    wheel->glitchCount = 0;
+    wheel->prevEdgeCount = 0;
+    wheel->prevEdgeTime = 0;
+    wheel->prevEdgeValid = false;
+    wheel->speed = 0;
+}
+
+// Called from the capture ISR with the captured timer value
+// Returns false if the edge was rejected as a glitch
+bool captureWheelEdge(WHEEL_SPEED* wheel, uint32_t captureTime)
+{
+    uint32_t period = captureTime - wheel->lastEdgeTime; // unsigned math handles the timer wrap
+
+    // A tab can't pass faster than the wheel can spin, and the wheel can't
+    // speed up 4x between two tabs, so anything shorter is noise on the input
+    if ((wheel->edgeCount != 0) && (period < WHEEL_MIN_PERIOD || period < (wheel->lastPeriod >> 2)))
+    {
+        wheel->glitchCount++;
+        return false;
+    }
+
+    wheel->lastPeriod = (wheel->edgeCount != 0 && period < WHEEL_TIMEOUT) ? period : 0;
+    wheel->lastEdgeTime = captureTime;
+    wheel->edgeCount++;
+    return true;
+}
+
+// Called once per control period with the current value of the free-running capture timer
+// Returns the speed in tabs/s
+float updateWheelSpeed(WHEEL_SPEED* wheel, uint32_t now)
+{
+    uint32_t count;
+    uint32_t edgeTime;
+    uint32_t edges;
+    uint32_t window;
+
+    // Take a consistent snapshot of the ISR data
+    do
+    {
+        count = wheel->edgeCount;
+        edgeTime = wheel->lastEdgeTime;
+    }
+    while (count != wheel->edgeCount);
+
+    edges = count - wheel->prevEdgeCount;
+
+    if (edges > 0)
+    {
+        if (wheel->prevEdgeValid)
+        {
+            // M edges over the exact time from the last edge of the previous window
+            window = edgeTime - wheel->prevEdgeTime;
+            wheel->speed = (float)edges * WHEEL_TIMER_HZ / window;
+        }
+        else if (wheel->lastPeriod != 0)
+        {
+            // First window after standing still, fall back to the last edge period
+            wheel->speed = (float)WHEEL_TIMER_HZ / wheel->lastPeriod;
+        }
+        else
+        {
+            wheel->speed = 0;
+        }
+        wheel->prevEdgeTime = edgeTime;
+        wheel->prevEdgeValid = true;
+    }
+    else if (wheel->prevEdgeValid)
+    {
+        window = now - wheel->prevEdgeTime;
+        if (window > WHEEL_TIMEOUT)
+        {
+            // No edge for too long, the wheel has stopped
+            wheel->speed = 0;
+            wheel->prevEdgeValid = false;
+        }
+        else if (wheel->speed * window > WHEEL_TIMER_HZ)
+        {
+            // The next edge is late, so the wheel is at most this fast
+            wheel->speed = (float)WHEEL_TIMER_HZ / window;
+        }
+    }
+
+    wheel->prevEdgeCount = count;
+    return wheel->speed;
+}
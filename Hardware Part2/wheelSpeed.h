@@ -0,0 +1,54 @@
+// Wheel Speed Library
+// Xavier
+
+//-----------------------------------------------------------------------------
+// Hardware Target
+//-----------------------------------------------------------------------------
+
+// Target Platform: EK-TM4C123GXL
+// Target uC:       TM4C123GH6PM
+// System Clock:    80 MHz
+
+// Hardware configuration:
+// OPB876N55 optical interrupters on WT1CCP0 (left) and WT5CCP0 (right),
+// wide timers in 32-bit edge-time capture mode counting up
+
+//-----------------------------------------------------------------------------
+// Device includes, defines, and assembler directives
+//-----------------------------------------------------------------------------
+
+#ifndef WHEELSPEED_H_
+#define WHEELSPEED_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "clock.h"
+
+// General Defines
+#define WHEEL_TIMER_HZ       SYSTEM_CLOCK_HZ           // capture timers run from the system clock
+#define WHEEL_TABS           40                        // tabs per wheel revolution // 1 tab = 1 cm
+#define WHEEL_MIN_PERIOD     (WHEEL_TIMER_HZ / 1000)   // 1 ms, edges closer than this are glitches
+#define WHEEL_TIMEOUT        (WHEEL_TIMER_HZ / 4)      // 250 ms without an edge means the wheel stopped
+
+// Structs
+typedef struct _WHEEL_SPEED
+{
+    volatile uint32_t edgeCount;    // accepted edges, written by the capture ISR
+    volatile uint32_t lastEdgeTime; // capture value of the last accepted edge
+    volatile uint32_t lastPeriod;   // ticks between the last two accepted edges (0 = unknown)
+    volatile uint32_t glitchCount;  // edges rejected by the glitch filter
+    uint32_t prevEdgeCount;         // edgeCount at the previous update
+    uint32_t prevEdgeTime;          // lastEdgeTime at the previous update
+    bool prevEdgeValid;             // prevEdgeTime can be used as the start of a window
+    float speed;                    // tabs/s
+} WHEEL_SPEED;
+
+//-----------------------------------------------------------------------------
+// Subroutines
+//-----------------------------------------------------------------------------
+
+void initWheelSpeed(WHEEL_SPEED* wheel);
+bool captureWheelEdge(WHEEL_SPEED* wheel, uint32_t captureTime);
+float updateWheelSpeed(WHEEL_SPEED* wheel, uint32_t now);
+
+#endif
@@ -0,0 +1,118 @@
+#!/usr/bin/env python3
+# Perfect hash for the CLI command table
+# Xavier
+#
+# Reads the names of commandTable in Project.c, in order, and searches for an
+# FNV-1a seed that puts every name in its own slot of the smallest power of
+# two table it can. Writes "Hardware Part2/commandHash.h" with the seed and
+# the slot table (index into commandTable + 1, 0 for a free slot) for
+# commands.c. Rerun it after adding, removing, renaming or reordering
+# commands; on the target initCommands() reports a stale header.
+#
+# Usage:
+#   python3 tools/command_hash.py
+#   python3 tools/command_hash.py --check      # exit 1 if commandHash.h is stale
+
+import argparse
+import os
+import re
+import sys
+
+FNV_PRIME = 16777619
+MAX_TRIES = 1000000
+
+here = os.path.dirname(os.path.abspath(__file__))
+SOURCE = os.path.normpath(os.path.join(here, "..", "Hardware Part2", "Project.c"))
+OUTPUT = os.path.normpath(os.path.join(here, "..", "Hardware Part2", "commandHash.h"))
+
+
+def read_names(path):
+    text = open(path, encoding="latin-1").read()
+    match = re.search(r"const COMMAND commandTable\[\]\s*=\s*\{(.*?)\n\};", text, re.S)
+    if not match:
+        sys.exit("no commandTable in " + path)
+    names = re.findall(r"^\s*\{\s*\"([^\"]+)\"", match.group(1), re.M)
+    if len(set(names)) != len(names):
+        sys.exit("duplicate command names in commandTable")
+    return names
+
+
+def fnv(name, seed, bits):
+    h = seed
+    for c in name.encode("ascii"):
+        h ^= c
+        h = (h * FNV_PRIME) & 0xFFFFFFFF
+    return h >> (32 - bits)
+
+
+def search(names):
+    bits = max(1, (len(names) - 1).bit_length())
+    while bits <= 8:
+        for seed in range(0x811C9DC5, 0x811C9DC5 + MAX_TRIES):
+            slots = set()
+            for name in names:
+                slot = fnv(name, seed & 0xFFFFFFFF, bits)
+                if slot in slots:
+                    break
+                slots.add(slot)
+            else:
+                return seed & 0xFFFFFFFF, bits
+        bits += 1
+    sys.exit("no seed found")
+
+
+def render(names, seed, bits):
+    slots = [0] * (1 << bits)
+    for i, name in enumerate(names):
+        slots[fnv(name, seed, bits)] = i + 1
+    rows = ",\n".join("    " + ", ".join("%2u" % s for s in slots[i:i + 16]) for i in range(0, len(slots), 16))
+
+    return "\n".join([
+        "// Command Hash",
+        "// Generated by tools/command_hash.py, do not edit",
+        "",
+        "// %u commands in %u slots: %s" % (len(names), len(slots), " ".join(names)),
+        "",
+        "#ifndef COMMANDHASH_H_",
+        "#define COMMANDHASH_H_",
+        "",
+        "#define COMMAND_HASH_SEED  0x%08X" % seed,
+        "#define COMMAND_HASH_BITS  %u" % bits,
+        "#define COMMAND_HASH_COUNT %u" % len(names),
+        "",
+        "// commandTable index + 1 by slot, 0 if free",
+        "#define COMMAND_HASH_SLOTS \\",
+        "{ \\",
+        " \\\n".join(rows.split("\n")) + " \\",
+        "}",
+        "",
+        "#endif",
+        "",
+    ])
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Generate commandHash.h from the command table")
+    parser.add_argument("--source", default=SOURCE)
+    parser.add_argument("-o", "--output", default=OUTPUT)
+    parser.add_argument("--check", action="store_true", help="only check that the output is up to date")
+    args = parser.parse_args()
+
+    names = read_names(args.source)
+    seed, bits = search(names)
+    text = render(names, seed, bits)
+
+    if args.check:
+        current = open(args.output).read() if os.path.exists(args.output) else ""
+        if current != text:
+            sys.exit("%s is out of date, run tools/command_hash.py" % args.output)
+        print("%s is up to date" % args.output)
+        return
+
+    with open(args.output, "w") as f:
+        f.write(text)
+    print("%u commands in %u slots, seed 0x%08X, written to %s" % (len(names), 1 << bits, seed, args.output))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,192 @@
+// Format benchmark
+// Xavier
+//
+// Runs the formatter of the firmware (format.c) and the C library's snprintf
+// on the same format strings, checks they print the same text and times both.
+// The cases are what the CLI prints: integers, hex, the sensor floats and
+// padded columns. %q has no snprintf equivalent, so it is checked against
+// snprintf("%f") of the value it stands for.
+// Host timings only rank the two, the M4 has no double FPU and the gap is
+// wider there. For code size, build both for the target and compare:
+//   arm-none-eabi-gcc -Os -mcpu=cortex-m4 -mthumb -mfloat-abi=hard -mfpu=fpv4-sp-d16 -c "Hardware Part2/format.c"
+//   arm-none-eabi-size format.o
+//   arm-none-eabi-gcc -Os -mcpu=cortex-m4 -mthumb --specs=nano.specs --specs=nosys.specs -u _printf_float
+//       -Wl,--gc-sections -DUSE_SNPRINTF tools/format_bench.c -o snprintf.elf
+//   arm-none-eabi-size snprintf.elf
+//
+// Usage:
+//   cc -O2 -I"Hardware Part2" tools/format_bench.c "Hardware Part2/format.c" -o format_bench && ./format_bench
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef USE_SNPRINTF
+
+// Size build, only snprintf with floats linked in
+int main(void)
+{
+    char buffer[64];
+    volatile double x = 1.5;
+    return snprintf(buffer, sizeof(buffer), "%d %u %x %8.3f %s", -1, 2u, 3u, x, "s");
+}
+
+#else
+
+#include "format.h"
+
+#define ITERATIONS 200000
+
+typedef enum
+{
+    ARGS_INT,
+    ARGS_UINT,
+    ARGS_LONG_LONG,
+    ARGS_DOUBLE,
+    ARGS_STRING,
+    ARGS_MIXED
+} ArgsType;
+
+typedef struct _BENCH_CASE
+{
+    const char* format;
+    ArgsType args;
+    double value;
+} BENCH_CASE;
+
+const BENCH_CASE cases[] =
+{
+    { "%d",                 ARGS_INT,       -123456 },
+    { "%u",                 ARGS_UINT,      4000000000.0 },
+    { "%08x",               ARGS_UINT,      48879 },
+    { "%#X",                ARGS_UINT,      3735928559.0 },
+    { "%-6d|",              ARGS_INT,       42 },
+    { "%+.5d",              ARGS_INT,       17 },
+    { "%llu",               ARGS_LONG_LONG, 12345678901234.0 },
+    { "%f",                 ARGS_DOUBLE,    3.14159265 },
+    { "%f",                 ARGS_DOUBLE,    -0.0000004 },
+    { "%.2f",               ARGS_DOUBLE,    -2.675 },
+    { "%10.3f",             ARGS_DOUBLE,    981.0 },
+    { "%-10.1f|",           ARGS_DOUBLE,    -7.25 },
+    { "%010.4f",            ARGS_DOUBLE,    -1.5 },
+    { "%.0f",               ARGS_DOUBLE,    2.5 },
+    { "%.0f",               ARGS_DOUBLE,    0.6 },
+    { "%#.0f",              ARGS_DOUBLE,    3.0 },
+    { "%.12f",              ARGS_DOUBLE,    0.1 },
+    { "%f",                 ARGS_DOUBLE,    123456789012.375 },
+    { "%.3f",               ARGS_DOUBLE,    0.9995 },
+    { "%s",                 ARGS_STRING,    0 },
+    { "%-12.4s|",           ARGS_STRING,    0 },
+    { "ax: %f  ay: %f  az: %f  gx: %f  gy: %f  gz: %f\n", ARGS_MIXED, 0 },
+};
+
+typedef uint32_t (*FORMATTER)(char* buffer, uint32_t size, const char* format, ...);
+
+uint32_t runSnprintf(char* buffer, uint32_t size, const char* format, ...)
+{
+    va_list args;
+    int length;
+
+    va_start(args, format);
+    length = vsnprintf(buffer, size, format, args);
+    va_end(args);
+    return length;
+}
+
+uint32_t run(FORMATTER f, char* buffer, uint32_t size, const BENCH_CASE* c)
+{
+    switch (c->args)
+    {
+        case ARGS_INT:       return f(buffer, size, c->format, (int)c->value);
+        case ARGS_UINT:      return f(buffer, size, c->format, (unsigned int)c->value);
+        case ARGS_LONG_LONG: return f(buffer, size, c->format, (unsigned long long)c->value);
+        case ARGS_DOUBLE:    return f(buffer, size, c->format, c->value);
+        case ARGS_STRING:    return f(buffer, size, c->format, "balance");
+        case ARGS_MIXED:     return f(buffer, size, c->format, 0.01f, -0.02f, 0.998f, -1.25f, 0.5f, 12.75f);
+    }
+    return 0;
+}
+
+double nsPerCall(FORMATTER f, const BENCH_CASE* c)
+{
+    char buffer[128];
+    struct timespec start, end;
+    uint32_t i;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < ITERATIONS; i++)
+    {
+        run(f, buffer, sizeof(buffer), c);
+        __asm__ volatile("" : : "r"(buffer) : "memory");
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    return ((end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec)) / ITERATIONS;
+}
+
+// %q against the value it holds, printed by snprintf
+bool checkQ(const char* qFormat, const char* fFormat, int32_t raw, uint8_t bits)
+{
+    char ours[64];
+    char theirs[64];
+
+    formatString(ours, sizeof(ours), qFormat, raw);
+    snprintf(theirs, sizeof(theirs), fFormat, (double)raw / ((uint64_t)1 << bits));
+    if (strcmp(ours, theirs) != 0)
+    {
+        printf("MISMATCH %-10s \"%s\" snprintf \"%s\"\n", qFormat, ours, theirs);
+        return false;
+    }
+    return true;
+}
+
+int main(void)
+{
+    char ours[128];
+    char theirs[128];
+    uint32_t oursLength, theirsLength;
+    double oursNs, theirsNs;
+    double oursTotal = 0, theirsTotal = 0;
+    uint32_t i;
+    uint32_t failures = 0;
+
+    printf("%-28s %10s %10s\n", "format", "format.c", "snprintf");
+    for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+    {
+        oursLength = run(formatString, ours, sizeof(ours), &cases[i]);
+        theirsLength = run(runSnprintf, theirs, sizeof(theirs), &cases[i]);
+        if (strcmp(ours, theirs) != 0 || oursLength != theirsLength)
+        {
+            printf("MISMATCH %s: \"%s\" snprintf \"%s\"\n", cases[i].format, ours, theirs);
+            failures++;
+        }
+
+        oursNs = nsPerCall(formatString, &cases[i]);
+        theirsNs = nsPerCall(runSnprintf, &cases[i]);
+        oursTotal += oursNs;
+        theirsTotal += theirsNs;
+        printf("%-28.28s %8.1fns %8.1fns\n", cases[i].format, oursNs, theirsNs);
+    }
+    printf("%-28s %8.1fns %8.1fns  (%.1fx)\n", "total", oursTotal, theirsTotal, theirsTotal / oursTotal);
+
+    failures += !checkQ("%q15", "%.5f", 16384, 15);
+    failures += !checkQ("%.3q15", "%.3f", -24576, 15);
+    failures += !checkQ("%q", "%.5f", 0x00018000, 16);
+    failures += !checkQ("%8.2q8", "%8.2f", -300, 8);
+    failures += !checkQ("%.9q31", "%.9f", 0x7FFFFFFF, 31);
+
+    // Cut output still counts the whole length and ends in '\0'
+    oursLength = formatString(ours, 4, "%d", 123456);
+    if (oursLength != 6 || strcmp(ours, "123") != 0)
+    {
+        printf("MISMATCH truncation: \"%s\" %u\n", ours, oursLength);
+        failures++;
+    }
+
+    printf("%u mismatches\n", failures);
+    return failures != 0;
+}
+
+#endif
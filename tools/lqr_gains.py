@@ -0,0 +1,188 @@
+#!/usr/bin/env python3
+# LQR gain synthesis for the balance controller
+# Xavier
+#
+# Linearizes the inverted pendulum on wheels about upright, discretizes it at
+# the control period, solves the discrete algebraic Riccati equation and
+# writes "Hardware Part2/lqrGains.h" for the on-target kernel in lqrControl.c.
+#
+# State:  x = [tilt (rad), tilt rate (rad/s), wheel position (m), wheel velocity (m/s)]
+# Input:  u = normalized motor command, -1 (full reverse) .. 1 (full forward)
+# Tilt is positive leaning backward, the same sign calculateTiltAngle() gives,
+# so driving forward pushes the tilt positive.
+#
+# Pure Python so it runs anywhere without numpy.
+#
+# Usage:
+#   python3 tools/lqr_gains.py                       # defaults below
+#   python3 tools/lqr_gains.py --mass 1.2 --com 0.12 --period 0.01 -o lqrGains.h
+
+import argparse
+import math
+import os
+import sys
+
+G = 9.81
+
+
+def matmul(a, b):
+    return [[sum(a[i][k] * b[k][j] for k in range(len(b))) for j in range(len(b[0]))] for i in range(len(a))]
+
+
+def matadd(a, b, s=1.0):
+    return [[a[i][j] + s * b[i][j] for j in range(len(a[0]))] for i in range(len(a))]
+
+
+def scale(a, s):
+    return [[v * s for v in row] for row in a]
+
+
+def transpose(a):
+    return [list(row) for row in zip(*a)]
+
+
+def identity(n):
+    return [[1.0 if i == j else 0.0 for j in range(n)] for i in range(n)]
+
+
+def expm(a):
+    # Scaling and squaring with a Taylor series, plenty for a 5x5 with small entries
+    norm = max(sum(abs(v) for v in row) for row in a)
+    squarings = max(0, int(math.ceil(math.log2(norm))) + 1) if norm > 0.5 else 0
+    a = scale(a, 1.0 / (2 ** squarings))
+    result = identity(len(a))
+    term = identity(len(a))
+    for k in range(1, 20):
+        term = scale(matmul(term, a), 1.0 / k)
+        result = matadd(result, term)
+    for _ in range(squarings):
+        result = matmul(result, result)
+    return result
+
+
+def continuous_model(p):
+    # Wheels are the cart, the body is the pendulum
+    # Each wheel adds its rolling inertia to the cart: m + J/r^2, J = m r^2 / 2 for a disc
+    body = p.mass
+    cart = 2 * (p.wheel_mass + 0.5 * p.wheel_mass)
+    l = p.com
+    inertia = body * l * l / 3            # body about its CoM, treated as a uniform rod of length 2l
+    r = p.radius
+
+    # Two motors, force at the ground: F = 2 tau / r
+    # tau = tau_stall * (u - omega / omega_noload), linear DC motor curve
+    force_max = 2 * p.stall_torque / r    # N per unit command
+    damping = force_max / (p.noload_speed * r)  # N per m/s from back-EMF
+
+    d = inertia * (cart + body) + cart * body * l * l
+    # CTMS cart-pole with phi measured from upright, reordered to [tilt, tilt rate, pos, vel]
+    a = [[0, 1, 0, 0],
+         [body * G * l * (cart + body) / d, 0, 0, -body * l * damping / d],
+         [0, 0, 0, 1],
+         [body * body * G * l * l / d, 0, 0, -(inertia + body * l * l) * damping / d]]
+    b = [[0],
+         [body * l * force_max / d],
+         [0],
+         [(inertia + body * l * l) * force_max / d]]
+    return a, b
+
+
+def discretize(a, b, ts):
+    # exp([[A B] [0 0]] ts) = [[Ad Bd] [0 I]]
+    n = len(a)
+    m = [a[i] + b[i] for i in range(n)] + [[0.0] * (n + 1)]
+    e = expm(scale(m, ts))
+    ad = [row[:n] for row in e[:n]]
+    bd = [[row[n]] for row in e[:n]]
+    return ad, bd
+
+
+def solve_dare(a, b, q, r, iterations=100000, tolerance=1e-10):
+    p = [row[:] for row in q]
+    at = transpose(a)
+    bt = transpose(b)
+    for _ in range(iterations):
+        pa = matmul(p, a)
+        pb = matmul(p, b)
+        btpb = matmul(bt, pb)[0][0]
+        btpa = matmul(bt, pa)
+        gain = scale(btpa, 1.0 / (r + btpb))
+        nxt = matadd(matadd(q, matmul(at, pa)), matmul(matmul(at, pb), gain), -1.0)
+        delta = max(abs(nxt[i][j] - p[i][j]) for i in range(len(p)) for j in range(len(p)))
+        p = nxt
+        if delta < tolerance:
+            break
+    pa = matmul(p, a)
+    pb = matmul(p, b)
+    btpb = matmul(transpose(b), pb)[0][0]
+    return scale(matmul(transpose(b), pa), 1.0 / (r + btpb))[0]
+
+
+def closed_loop_decay(a, b, k, steps=2000):
+    # Spectral radius estimate of A - B K from repeated application
+    acl = [[a[i][j] - b[i][0] * k[j] for j in range(4)] for i in range(4)]
+    x = [[1.0], [1.0], [1.0], [1.0]]
+    for _ in range(steps):
+        x = matmul(acl, x)
+        n = math.sqrt(sum(v[0] ** 2 for v in x))
+        if n == 0 or n > 1e12:
+            break
+    return n
+
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    parser = argparse.ArgumentParser(description="Synthesize LQR balance gains and write lqrGains.h")
+    parser.add_argument("--mass", type=float, default=1.0, help="body mass without wheels, kg")
+    parser.add_argument("--wheel-mass", type=float, default=0.05, help="mass of one wheel, kg")
+    parser.add_argument("--radius", type=float, default=0.064, help="wheel radius, m (40 tabs of 1 cm)")
+    parser.add_argument("--com", type=float, default=0.10, help="CoM height above the axle, m")
+    parser.add_argument("--stall-torque", type=float, default=0.30, help="stall torque of one motor at full PWM, Nm")
+    parser.add_argument("--noload-speed", type=float, default=20.0, help="no-load wheel speed at full PWM, rad/s")
+    parser.add_argument("--period", type=float, default=0.025, help="control period, s")
+    parser.add_argument("--q", type=float, nargs=4, default=[100.0, 1.0, 10.0, 1.0],
+                        metavar=("TILT", "RATE", "POS", "VEL"), help="state weights")
+    parser.add_argument("--r", type=float, default=1.0, help="input weight")
+    parser.add_argument("-o", "--output", default=os.path.join(here, "..", "Hardware Part2", "lqrGains.h"))
+    p = parser.parse_args()
+
+    a, b = continuous_model(p)
+    # The scheduler ticks every ms, the balance task can only run at whole ms
+    period_ms = int(round(p.period * 1000))
+    if period_ms < 1 or abs(period_ms / 1000.0 - p.period) > 1e-9:
+        sys.exit("period has to be a whole number of ms")
+
+    ad, bd = discretize(a, b, p.period)
+    q = [[p.q[i] if i == j else 0.0 for j in range(4)] for i in range(4)]
+    k = solve_dare(ad, bd, q, p.r)
+
+    if closed_loop_decay(ad, bd, k) > 1e-3:
+        sys.exit("closed loop is not stable, check the model parameters")
+
+    names = ["TILT", "TILT_RATE", "POSITION", "VELOCITY"]
+    lines = [
+        "// LQR Gains",
+        "// Generated by tools/lqr_gains.py, do not edit",
+        "",
+        "// " + " ".join(sys.argv[1:]) if len(sys.argv) > 1 else "// default parameters",
+        "// mass %.3f kg, wheel mass %.3f kg, radius %.4f m, CoM %.3f m" % (p.mass, p.wheel_mass, p.radius, p.com),
+        "// stall torque %.3f Nm, no-load speed %.1f rad/s, period %.4f s" % (p.stall_torque, p.noload_speed, p.period),
+        "// Q = diag(%s), R = %g" % (", ".join("%g" % v for v in p.q), p.r),
+        "",
+        "#ifndef LQRGAINS_H_",
+        "#define LQRGAINS_H_",
+        "",
+        "#define LQR_PERIOD %.6f" % p.period,
+        "#define LQR_PERIOD_MS %u      // has to match the balance task, Project.c checks it" % period_ms,
+        "",
+    ]
+    for name, gain in zip(names, k):
+        lines.append("#define LQR_K_%-10s %.6f" % (name, gain))
+    lines += ["", "#endif", ""]
+    with open(p.output, "w") as f:
+        f.write("\n".join(lines))
+    print("K = [" + ", ".join("%.4f" % v for v in k) + "] -> " + os.path.normpath(p.output))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+# Flash and RAM size analyzer
+# Xavier
+#
+# Ranks what takes up flash and RAM in a build, using the "SECTION ALLOCATION
+# MAP" of the TI linker map file. Input sections are named after the function
+# or variable they hold (the compiler puts each in its own subsection), so
+# the ranking is per symbol. Sections the compiler didn't split show up
+# under their object file instead.
+# Flash is code, constants and the initializers of .data (.cinit). RAM is
+# .data, .bss, .sysmem and .stack. The stack is listed on its own, and its
+# real use is printed by the `mem` command on the target.
+#
+# Usage:
+#   python3 tools/map_sizes.py Debug/Project.map
+#   python3 tools/map_sizes.py Debug/Project.map --top 40
+#   python3 tools/map_sizes.py Debug/Project.map --by-object
+
+import argparse
+import collections
+import re
+import sys
+
+FLASH_SECTIONS = (".intvecs", ".text", ".const", ".cinit", ".pinit", ".init_array", ".binit")
+RAM_SECTIONS = (".data", ".bss", ".sysmem", ".stack", ".vtable")
+
+OUTPUT_LINE = re.compile(r"^(\.\S+)\s+\d+\s+([0-9a-fA-F]{8})\s+([0-9a-fA-F]{8})")
+INPUT_LINE = re.compile(r"^\s+([0-9a-fA-F]{8})\s+([0-9a-fA-F]{8})\s+(.*?)\s*\(([^)]*)\)\s*$")
+MEMORY_LINE = re.compile(r"^\s+(FLASH|SRAM)\s+([0-9a-fA-F]{8})\s+([0-9a-fA-F]{8})\s+([0-9a-fA-F]{8})\s+([0-9a-fA-F]{8})")
+
+
+def region_of(section):
+    for name in FLASH_SECTIONS:
+        if section == name or section.startswith(name + "."):
+            return "flash"
+    for name in RAM_SECTIONS:
+        if section == name or section.startswith(name + "."):
+            return "ram"
+    return None
+
+
+def read_map(path):
+    memory = {}
+    entries = []    # (region, output section, object, symbol, size)
+    outputs = {}    # output section length
+    output = None
+    in_allocation = False
+
+    with open(path, errors="replace") as f:
+        for line in f:
+            line = line.rstrip("\n")
+
+            match = MEMORY_LINE.match(line)
+            if match:
+                memory[match.group(1)] = (int(match.group(3), 16), int(match.group(4), 16))
+                continue
+
+            if "SECTION ALLOCATION MAP" in line:
+                in_allocation = True
+                continue
+            if not in_allocation:
+                continue
+            if line.startswith("GLOBAL SYMBOLS") or line.startswith("LINKER GENERATED"):
+                break
+
+            match = OUTPUT_LINE.match(line)
+            if match:
+                output = match.group(1)
+                outputs[output] = int(match.group(3), 16)
+                continue
+
+            match = INPUT_LINE.match(line)
+            if match and output:
+                region = region_of(output)
+                size = int(match.group(2), 16)
+                if region is None or size == 0:
+                    continue
+                obj = match.group(3).replace(" : ", ":") or "(common)"
+                inner = match.group(4)
+                symbol = inner.split(":", 1)[1] if ":" in inner else inner
+                if symbol.startswith("common:"):
+                    symbol = symbol[len("common:"):]
+                entries.append((region, output, obj, symbol, size))
+
+    if not entries:
+        sys.exit("no section allocation found in " + path + ", is it a TI linker map?")
+    return memory, entries, outputs
+
+
+def print_ranking(title, rows, top):
+    total = sum(size for _, size in rows)
+    print("%s: %u bytes" % (title, total))
+    for name, size in rows[:top]:
+        share = 100.0 * size / total if total else 0
+        print("  %7u  %5.1f%%  %s" % (size, share, name))
+    if len(rows) > top:
+        rest = sum(size for _, size in rows[top:])
+        print("  %7u          %u more" % (rest, len(rows) - top))
+    print()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Rank symbols by flash and RAM size from a TI linker map")
+    parser.add_argument("map", help="linker .map file")
+    parser.add_argument("--top", type=int, default=25, help="rows per ranking")
+    parser.add_argument("--by-object", action="store_true", help="rank object files instead of symbols")
+    args = parser.parse_args()
+
+    memory, entries, outputs = read_map(args.map)
+
+    for name, (length, used) in sorted(memory.items()):
+        print("%-5s %7u of %7u bytes used (%.1f%%)" % (name, used, length, 100.0 * used / length))
+    if memory:
+        print()
+
+    for region, title in (("flash", "Flash"), ("ram", "RAM")):
+        sizes = collections.Counter()
+        for entry_region, output, obj, symbol, size in entries:
+            if entry_region != region or output == ".stack":
+                continue
+            if args.by_object:
+                key = obj
+            else:
+                key = "%s  (%s %s)" % (symbol, obj, output)
+            sizes[key] += size
+        print_ranking(title, sizes.most_common(), args.top)
+
+    if ".stack" in outputs:
+        print("Stack: %u bytes reserved, run `mem` on the target for the high-water mark" % outputs[".stack"])
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,104 @@
+#!/usr/bin/env python3
+# Motion script uploader
+# Xavier
+#
+# Sends a motion script (script.c) to the robot over the CLI UART: `script
+# load`, one step per line, then `done`. Text after a # is a comment and
+# blank lines are skipped, so a course can be kept as a commented file next
+# to its results. Every line waits for the robot's echo before the next one
+# goes out, the receive ring never fills however long the script is. The
+# robot checks each line as it arrives; the upload stops at the first line
+# it rejects and the robot keeps no script then.
+# With --run the script is started once it loaded and the output is shown
+# until the script ends.
+#
+# Example course:
+#   abort 30          # stop everything if it tips past 30 deg
+#   repeat 4
+#     forward 50cm
+#     settle
+#     rotate cw 90
+#   end
+#
+# Usage:
+#   python3 tools/script_upload.py --port /dev/ttyACM0 square.txt
+#   python3 tools/script_upload.py --port /dev/ttyACM0 --run square.txt
+
+import argparse
+import sys
+import time
+
+LINE_TIMEOUT = 1.0      # s for the robot to echo a line
+RUN_TIMEOUT = 600.0     # s a --run may take
+
+
+def read_steps(path):
+    steps = []
+    for line in open(path):
+        line = line.split("#", 1)[0].strip()
+        if line:
+            steps.append(line)
+    return steps
+
+
+def read_until(s, marks, timeout):
+    # Text from the robot up to and including a line holding one of marks
+    text = b""
+    end = time.time() + timeout
+    while time.time() < end:
+        text += s.read(s.in_waiting or 1)
+        for mark in marks:
+            if mark in text and text.endswith(b"\n"):
+                return text.decode("ascii", "replace"), mark
+    return text.decode("ascii", "replace"), None
+
+
+def send(s, line, marks=(b"\n",), timeout=LINE_TIMEOUT):
+    s.write(line.encode("ascii") + b"\r")
+    return read_until(s, marks, timeout)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Upload a motion script to the robot")
+    parser.add_argument("script", help="script file, one step per line")
+    parser.add_argument("--port", required=True, help="serial port of the robot")
+    parser.add_argument("--baud", type=int, default=115200, help="rate the robot is at")
+    parser.add_argument("--run", action="store_true", help="run the script after loading it")
+    args = parser.parse_args()
+
+    try:
+        import serial
+    except ImportError:
+        sys.exit("needs pyserial (pip install pyserial)")
+
+    steps = read_steps(args.script)
+    with serial.Serial(args.port, args.baud, timeout=0.1) as s:
+        s.write(b"\x15")                            # Ctrl-U, drop a half typed line
+        s.reset_input_buffer()
+        text, mark = send(s, "script load", (b"done to finish", b"stop it first"))
+        if mark != b"done to finish":
+            sys.exit("robot did not start the upload: " + text.strip())
+
+        for number, step in enumerate(steps, 1):
+            text, mark = send(s, step, (b"\n",))
+            # The echo comes back first, an error follows it right away
+            text += read_until(s, (b"script line",), 0.05)[0]
+            if mark is None or "script line" in text:
+                send(s, "done", (b"not loaded",))
+                sys.exit("line %u, %s: %s" % (number, step, text.strip()))
+
+        text, mark = send(s, "done", (b"script loaded", b"not loaded"))
+        print(text.strip())
+        if mark != b"script loaded":
+            sys.exit(1)
+
+        if args.run:
+            send(s, "script run")
+            text, mark = read_until(s, (b"Script done", b"Script aborted", b"Script stopped", b"Stopped"), RUN_TIMEOUT)
+            print(text.strip())
+            if mark != b"Script done":
+                sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,86 @@
+#!/usr/bin/env python3
+# Crash report symbolizer
+# Xavier
+#
+# Turns the pc and lr lines of a crash report printed at boot (crash.c) into
+# function+offset, using the linker map file of the build that crashed.
+# The map's "GLOBAL SYMBOLS: SORTED BY Symbol Address" section is used, so
+# static functions show up as the global one placed before them.
+#
+# Usage:
+#   python3 tools/symbolize_crash.py Debug/Project.map report.txt
+#   python3 tools/symbolize_crash.py Debug/Project.map < report.txt
+#   python3 tools/symbolize_crash.py Debug/Project.map --address 0x1a2b
+
+import argparse
+import bisect
+import re
+import sys
+
+SECTION = "GLOBAL SYMBOLS: SORTED BY Symbol Address"
+SYMBOL_LINE = re.compile(r"^\s*([0-9a-fA-F]{8})\s+(\S+)\s*$")
+REGISTER_LINE = re.compile(r"\b(pc|lr)\s+(?:0x)?([0-9a-fA-F]+)")
+
+# Code lives in flash, anything else in the map (RAM, peripherals, linker
+# constants) can't be where a pc points
+FLASH_END = 0x00040000
+
+
+def read_symbols(path):
+    addresses = []
+    names = []
+    in_section = False
+    with open(path, errors="replace") as f:
+        for line in f:
+            if SECTION in line:
+                in_section = True
+                continue
+            if not in_section:
+                continue
+            if line.startswith("GLOBAL SYMBOLS") or line.startswith("["):
+                break
+            match = SYMBOL_LINE.match(line)
+            if not match:
+                continue
+            address = int(match.group(1), 16) & ~1
+            if address < FLASH_END:
+                addresses.append(address)
+                names.append(match.group(2))
+    if not addresses:
+        sys.exit("no symbols found in " + path + ", is it a TI linker map?")
+    return addresses, names
+
+
+def symbolize(addresses, names, value):
+    value &= ~1     # thumb bit
+    i = bisect.bisect_right(addresses, value) - 1
+    if i < 0:
+        return "?"
+    return "%s+0x%x" % (names[i], value - addresses[i])
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("map", help="linker .map file of the crashed build")
+    parser.add_argument("report", nargs="?", help="crash report text, stdin if omitted")
+    parser.add_argument("--address", action="append", default=[], help="symbolize one address instead")
+    args = parser.parse_args()
+
+    addresses, names = read_symbols(args.map)
+
+    if args.address:
+        for text in args.address:
+            print("%s  %s" % (text, symbolize(addresses, names, int(text, 16))))
+        return
+
+    report = open(args.report, errors="replace") if args.report else sys.stdin
+    for line in report:
+        line = line.rstrip("\n")
+        match = REGISTER_LINE.search(line)
+        if match:
+            line += "  " + symbolize(addresses, names, int(match.group(2), 16))
+        print(line)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,392 @@
+#!/usr/bin/env python3
+# Telemetry decoder
+# Xavier
+#
+# Reads the binary telemetry stream the robot sends on the CLI UART
+# (telemetry.c) from the serial port or from a capture file, checks every
+# packet and writes columnar output. Frames are COBS encoded between zero
+# bytes with a CRC-16/CCITT at the end; anything between frames is CLI text
+# and is passed through to stderr.
+# Samples hold only the channels that were selected, so columns of channels
+# that were off at the time are empty (NaN) for those rows. Timing packets
+# carry cycles and are converted to us with the cycles/us they were sent with.
+# Sequence numbers are shared by all packet types, gaps are packets the
+# robot skipped on a full UART ring or that were lost on the line.
+# Scope captures (scope.c) come as a header and data packets and are written
+# one row per sample, with the time in ms from the trigger sample.
+#
+# Output:
+#   name.csv               name.samples.csv and name.timing.csv, and
+#                          name.scope.csv if there were scope captures
+#   out directory          samples.parquet, timing.parquet and scope.parquet
+#                          if pyarrow is installed, otherwise one raw
+#                          little-endian .bin per column and a schema.json
+#                          describing them
+#
+# With --fast the robot is switched to a faster rate for the recording with
+# the `baud` handshake, and back to --baud afterwards.
+#
+# Usage:
+#   python3 tools/telemetry_decode.py --port /dev/ttyACM0 --baud 115200 --seconds 10 run.csv
+#   python3 tools/telemetry_decode.py --port /dev/ttyUSB0 --fast 2000000 --seconds 10 run.csv
+#   python3 tools/telemetry_decode.py capture.bin run.csv
+#   python3 tools/telemetry_decode.py capture.bin rundir
+
+import argparse
+import json
+import math
+import os
+import struct
+import sys
+import time
+
+PACKET_SAMPLE = 1
+PACKET_TIMING = 2
+PACKET_SCOPE_HEADER = 3
+PACKET_SCOPE_DATA = 4
+SCOPE_FLOAT = 0         # other scope types arrive widened to int32
+SCOPE_CONDITIONS = {0: "%s > %g", 1: "%s < %g", 2: "|%s| > %g"}
+TIMING_BUCKETS = 8
+
+# Channel bit, name, struct format, column names (telemetry.h)
+CHANNELS = (
+    (0x0001, "tilt", "<f", ("tilt",)),
+    (0x0002, "gyro", "<3f", ("gx", "gy", "gz")),
+    (0x0004, "accel", "<3f", ("ax", "ay", "az")),
+    (0x0008, "pwm", "<2h", ("pwm_left", "pwm_right")),
+    (0x0010, "wheels", "<2i2f", ("count_left", "count_right", "rate_left", "rate_right")),
+    (0x0020, "pid", "<4f", ("error", "integral", "derivative", "output")),
+    (0x0040, "pose", "<3f", ("x", "y", "theta")),
+)
+INTEGER_COLUMNS = ("pwm_left", "pwm_right", "count_left", "count_right")
+
+SAMPLE_COLUMNS = ["seq", "time_us", "channels"] + [c for _, _, _, names in CHANNELS for c in names]
+TIMING_COLUMNS = (["seq", "time_us", "task", "name", "period_us", "runs", "min_us", "avg_us", "max_us",
+                   "max_jitter_us", "misses"]
+                  + ["exec_%u" % i for i in range(TIMING_BUCKETS)]
+                  + ["jitter_%u" % i for i in range(TIMING_BUCKETS)])
+
+
+def crc16(data):
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_decode(frame):
+    out = bytearray()
+    i = 0
+    while i < len(frame):
+        code = frame[i]
+        if code == 0 or i + code > len(frame):
+            return None
+        out += frame[i + 1:i + code]
+        i += code
+        if code != 0xFF and i < len(frame):
+            out.append(0)
+    return bytes(out)
+
+
+def parse_sample(header, body):
+    (channels,) = struct.unpack_from("<H", body)
+    offset = 2
+    row = dict.fromkeys(SAMPLE_COLUMNS, math.nan)
+    row.update(header)
+    row["channels"] = channels
+    for bit, _, fmt, names in CHANNELS:
+        if channels & bit:
+            row.update(zip(names, struct.unpack_from(fmt, body, offset)))
+            offset += struct.calcsize(fmt)
+    if offset != len(body):
+        return None
+    return row
+
+
+def parse_timing(header, body):
+    fmt = "<BB8s7I%uI%uI" % (TIMING_BUCKETS, TIMING_BUCKETS)
+    if len(body) != struct.calcsize(fmt):
+        return None
+    values = struct.unpack(fmt, body)
+    task, cycles_per_us, name = values[0], values[1] or 1, values[2]
+    period, runs, minimum, average, maximum, jitter, misses = values[3:10]
+    row = dict(header)
+    row.update(task=task, name=name.rstrip(b"\0").decode("ascii", "replace"),
+               period_us=period / cycles_per_us, runs=runs, min_us=minimum / cycles_per_us,
+               avg_us=average / cycles_per_us, max_us=maximum / cycles_per_us,
+               max_jitter_us=jitter / cycles_per_us, misses=misses)
+    for i in range(TIMING_BUCKETS):
+        row["exec_%u" % i] = values[10 + i]
+        row["jitter_%u" % i] = values[10 + TIMING_BUCKETS + i]
+    return row
+
+
+def parse_scope_header(body):
+    fmt = "<BBBIHHBf8s"
+    size = struct.calcsize(fmt)
+    if len(body) < size:
+        return None
+    capture, count, decimation, tick_us, pre, post, condition, level, trigger = struct.unpack_from(fmt, body)
+    if len(body) != size + 9 * count:
+        return None
+    types = []
+    names = []
+    for i in range(count):
+        offset = size + 9 * i
+        types.append(body[offset])
+        names.append(body[offset + 1:offset + 9].rstrip(b"\0").decode("ascii", "replace"))
+    return {"capture": capture, "decimation": decimation, "tick_us": tick_us, "pre": pre, "post": post,
+            "condition": condition, "level": level, "trigger": trigger.rstrip(b"\0").decode("ascii", "replace"),
+            "types": types, "names": names, "samples": {}}
+
+
+def parse_scope_data(body, capture):
+    if capture is None or len(body) < 4:
+        return False
+    number, first, count = struct.unpack_from("<BHB", body)
+    fmt = "<" + "".join("f" if t == SCOPE_FLOAT else "i" for t in capture["types"]) * count
+    if number != capture["capture"] or len(body) != 4 + struct.calcsize(fmt):
+        return False
+    values = struct.unpack_from(fmt, body, 4)
+    width = len(capture["types"])
+    for i in range(count):
+        capture["samples"][first + i] = values[i * width:(i + 1) * width]
+    return True
+
+
+class Decoder:
+    def __init__(self):
+        self.samples = []
+        self.timing = []
+        self.scope = []
+        self.frames = 0
+        self.bad_crc = 0
+        self.bad_frames = 0
+        self.gaps = 0
+        self.lost = 0
+        self.last_seq = None
+        self.pending = bytearray()
+
+    def feed(self, data):
+        self.pending += data
+        while True:
+            end = self.pending.find(b"\0")
+            if end < 0:
+                break
+            chunk = bytes(self.pending[:end])
+            del self.pending[:end + 1]
+            if chunk:
+                self.frame(chunk)
+
+    def frame(self, chunk):
+        # Text that ran into a frame's leading zero is not COBS, show it and move on
+        packet = cobs_decode(chunk)
+        if packet is None or len(packet) < 9 or packet[0] not in (PACKET_SAMPLE, PACKET_TIMING,
+                                                                    PACKET_SCOPE_HEADER, PACKET_SCOPE_DATA):
+            self.text(chunk)
+            return
+        self.frames += 1
+        (crc,) = struct.unpack_from("<H", packet, len(packet) - 2)
+        if crc16(packet[:-2]) != crc:
+            self.bad_crc += 1
+            return
+        kind, seq, time_us = struct.unpack_from("<BHI", packet)
+        body = packet[7:-2]
+        header = {"seq": seq, "time_us": time_us}
+
+        if self.last_seq is not None:
+            missed = (seq - self.last_seq - 1) & 0xFFFF
+            if missed:
+                self.gaps += 1
+                self.lost += missed
+        self.last_seq = seq
+
+        if kind == PACKET_SCOPE_HEADER:
+            capture = parse_scope_header(body)
+            if capture is None:
+                self.bad_frames += 1
+            else:
+                self.scope.append(capture)
+            return
+        if kind == PACKET_SCOPE_DATA:
+            if not parse_scope_data(body, self.scope[-1] if self.scope else None):
+                self.bad_frames += 1
+            return
+
+        if kind == PACKET_SAMPLE:
+            row = parse_sample(header, body)
+            target = self.samples
+        else:
+            row = parse_timing(header, body)
+            target = self.timing
+        if row is None:
+            self.bad_frames += 1
+        else:
+            target.append(row)
+
+    @staticmethod
+    def text(chunk):
+        sys.stderr.write(chunk.decode("ascii", "replace"))
+
+    def scope_table(self):
+        # One row per sample of every capture, channels a capture didn't have are NaN
+        columns = ["capture", "sample", "time_ms"]
+        for capture in self.scope:
+            columns += [name for name in capture["names"] if name not in columns]
+        rows = []
+        for number, capture in enumerate(self.scope):
+            step_ms = capture["tick_us"] * capture["decimation"] / 1000.0
+            for sample in sorted(capture["samples"]):
+                row = dict.fromkeys(columns, math.nan)
+                row.update(capture=number, sample=sample, time_ms=(sample - capture["pre"]) * step_ms)
+                row.update(zip(capture["names"], capture["samples"][sample]))
+                rows.append(row)
+        return columns, rows
+
+    def summary(self):
+        text = ("%u frames, %u samples, %u timing, %u CRC errors, %u malformed, %u gaps (%u packets missing)"
+                % (self.frames, len(self.samples), len(self.timing), self.bad_crc, self.bad_frames,
+                   self.gaps, self.lost))
+        for capture in self.scope:
+            expected = capture["pre"] + 1 + capture["post"]
+            trigger = SCOPE_CONDITIONS.get(capture["condition"])
+            trigger = (trigger % (capture["trigger"], capture["level"])) if trigger else "none"
+            text += ("\nscope capture %u: %u of %u samples, %u before the trigger (%s)"
+                     % (capture["capture"], len(capture["samples"]), expected, capture["pre"], trigger))
+        return text
+
+
+def column_type(name, values):
+    if name == "name":
+        return "string"
+    if name in INTEGER_COLUMNS:
+        return "int32" if not any(isinstance(v, float) and math.isnan(v) for v in values) else "float64"
+    if name in ("seq", "channels", "task", "capture", "sample"):
+        return "uint16"
+    if name in ("time_us", "runs", "misses") or name.startswith("exec_") or name.startswith("jitter_"):
+        return "uint32"
+    return "float32" if name in SAMPLE_COLUMNS else "float64"
+
+
+def write_csv(path, columns, rows):
+    with open(path, "w") as f:
+        f.write(",".join(columns) + "\n")
+        for row in rows:
+            f.write(",".join("" if (isinstance(row[c], float) and math.isnan(row[c])) else str(row[c])
+                             for c in columns) + "\n")
+
+
+def write_columns(directory, table, columns, rows):
+    try:
+        import pyarrow
+        import pyarrow.parquet
+        pyarrow.parquet.write_table(pyarrow.table({c: [row[c] for row in rows] for c in columns}),
+                                    os.path.join(directory, table + ".parquet"))
+        return
+    except ImportError:
+        pass
+
+    # No pyarrow, raw columns anyone can np.fromfile
+    formats = {"uint16": "<H", "uint32": "<I", "int32": "<i", "float32": "<f", "float64": "<d"}
+    schema = {"rows": len(rows), "columns": []}
+    for c in columns:
+        values = [row[c] for row in rows]
+        kind = column_type(c, values)
+        path = os.path.join(directory, "%s.%s.bin" % (table, c))
+        with open(path, "wb") as f:
+            if kind == "string":
+                f.write(b"".join(v.encode("ascii", "replace")[:8].ljust(8, b"\0") for v in values))
+                kind = "S8"
+            else:
+                f.write(b"".join(struct.pack(formats[kind], v) for v in values))
+        schema["columns"].append({"name": c, "type": kind, "file": os.path.basename(path)})
+    with open(os.path.join(directory, table + ".schema.json"), "w") as f:
+        json.dump(schema, f, indent=2)
+
+
+def wait_for(s, text, seconds):
+    seen = b""
+    end = time.time() + seconds
+    while time.time() < end:
+        seen += s.read(256)
+        if text in seen:
+            return True
+    return False
+
+
+def switch_baud(s, rate):
+    # The robot answers at the old rate, then waits 2 s for "ok" at the new one
+    # Ctrl-U clears whatever arrived garbled while the two rates differed
+    s.reset_input_buffer()
+    s.write(b"\rbaud %u\r" % rate)
+    if not wait_for(s, b"send ok", 1):
+        sys.exit("the robot refused %u baud or didn't answer" % rate)
+    time.sleep(0.05)
+    s.baudrate = rate
+    s.reset_input_buffer()
+    s.write(b"\x15ok\r")
+    if not wait_for(s, b"confirmed", 1):
+        sys.exit("no confirmation at %u baud, the robot goes back to the old rate" % rate)
+
+
+def read_serial(decoder, port, baud, fast, seconds):
+    try:
+        import serial
+    except ImportError:
+        sys.exit("reading a port needs pyserial (pip install pyserial), or pass a capture file")
+    with serial.Serial(port, baud, timeout=0.1) as s:
+        if fast:
+            switch_baud(s, fast)
+        s.write(b"telemetry on\r")
+        end = time.time() + seconds
+        try:
+            while time.time() < end:
+                decoder.feed(s.read(4096))
+        finally:
+            s.write(b"\rtelemetry off\r")
+            if fast:
+                time.sleep(0.1)
+                switch_baud(s, baud)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Decode the robot's binary telemetry stream")
+    parser.add_argument("input", nargs="?", help="capture file, or use --port")
+    parser.add_argument("output", help="name.csv for CSV files, a directory for columnar output")
+    parser.add_argument("--port", help="serial port to record from")
+    parser.add_argument("--baud", type=int, default=115200, help="rate the robot is at")
+    parser.add_argument("--fast", type=int, help="rate to switch the robot to while recording")
+    parser.add_argument("--seconds", type=float, default=10, help="how long to record from the port")
+    args = parser.parse_args()
+
+    decoder = Decoder()
+    if args.port:
+        read_serial(decoder, args.port, args.baud, args.fast, args.seconds)
+    elif args.input:
+        with open(args.input, "rb") as f:
+            decoder.feed(f.read())
+    else:
+        parser.error("give a capture file or --port")
+    decoder.text(bytes(decoder.pending))
+
+    if args.output.endswith(".csv"):
+        base = args.output[:-len(".csv")]
+        write_csv(base + ".samples.csv", SAMPLE_COLUMNS, decoder.samples)
+        write_csv(base + ".timing.csv", TIMING_COLUMNS, decoder.timing)
+        if decoder.scope:
+            write_csv(base + ".scope.csv", *decoder.scope_table())
+    else:
+        os.makedirs(args.output, exist_ok=True)
+        write_columns(args.output, "samples", SAMPLE_COLUMNS, decoder.samples)
+        write_columns(args.output, "timing", TIMING_COLUMNS, decoder.timing)
+        if decoder.scope:
+            write_columns(args.output, "scope", *decoder.scope_table())
+
+    print(decoder.summary())
+
+
+if __name__ == "__main__":
+    main()